@@ -0,0 +1,99 @@
+#ifndef BASIC_BRIDGE_HPP
+#define BASIC_BRIDGE_HPP
+
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+// Basic Bridge.
+
+// The Bridge Pattern for any abstraction, rather than for the one Behaviour hierarchy of Bridge.hpp: BasicBridge<Abstraction,
+// ImplementationSet<First, Second, ...>> holds one implementation of the abstraction out of a closed set, and can switch to another at
+// run time.
+
+// (*) The implementation is kept inline in a std::variant, the way VariantBehaviourHolder keeps its behaviour: a bridge allocates
+//     nothing and owns its implementation by value.
+
+// (*) Every implementation derives from the abstraction, so the bridge can be used through it (*, ->) wherever the caller doesn't care
+//     which implementation is active. Visit hands the active implementation over as its own type instead, through std::visit: with final
+//     implementation classes nothing is virtual, and the call can be inlined.
+
+
+// The closed set of implementations a bridge can switch between. The first one is what a bridge starts out with.
+template <typename... Implementations>
+class ImplementationSet {
+};
+
+
+template <typename Abstraction, typename Implementations>
+class BasicBridge;
+
+template <typename Abstraction, typename... Implementations>
+class BasicBridge<Abstraction, ImplementationSet<Implementations...>> {
+
+  static_assert ((std::is_base_of_v<Abstraction, Implementations> && ...), "Every implementation has to derive from the abstraction.");
+
+public:
+
+  // Starts out with a default constructed first implementation.
+  BasicBridge (void) = default;
+
+  // Starts out with an Implementation constructed from the arguments.
+  template <typename Implementation, typename... Arguments>
+  explicit BasicBridge (std::in_place_type_t<Implementation> implementation_type, Arguments&&... arguments)
+
+      : implementation (implementation_type, std::forward<Arguments> (arguments)...) {
+  }
+
+  // Switches to an Implementation constructed from the arguments.
+  template <typename Implementation, typename... Arguments>
+  Implementation& Set (Arguments&&... arguments) {
+
+    return this->implementation.template emplace<Implementation> (std::forward<Arguments> (arguments)...);
+  }
+
+  template <typename Implementation>
+  bool Holds (void) const noexcept {
+
+    return std::holds_alternative<Implementation> (this->implementation);
+  }
+
+  // Calls the visitor with the active implementation, as its own type.
+  template <typename Visitor>
+  decltype (auto) Visit (Visitor&& visitor) {
+
+    return std::visit (std::forward<Visitor> (visitor), this->implementation);
+  }
+
+  template <typename Visitor>
+  decltype (auto) Visit (Visitor&& visitor) const {
+
+    return std::visit (std::forward<Visitor> (visitor), this->implementation);
+  }
+
+  Abstraction& operator* (void) {
+
+    return this->Visit ([] (auto& active_implementation) -> Abstraction& { return active_implementation; });
+  }
+
+  const Abstraction& operator* (void) const {
+
+    return this->Visit ([] (const auto& active_implementation) -> const Abstraction& { return active_implementation; });
+  }
+
+  Abstraction* operator-> (void) {
+
+    return &**this;
+  }
+
+  const Abstraction* operator-> (void) const {
+
+    return &**this;
+  }
+
+private:
+
+  std::variant<Implementations...> implementation;
+};
+
+#endif
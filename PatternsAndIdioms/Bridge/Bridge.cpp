@@ -1,250 +1,97 @@
-#include <iostream>
-#include <string>
+#include "BasicBridge.hpp"
+#include "Bridge.hpp"
 
-// Bridge Pattern Idiom.
 
-// Motivation:
+// An abstraction of our own, bridged to its implementations through BasicBridge.
+class Greeter {
 
-// (1) With typical class definitions, the object representation is usually hard-coupled with its implementation. 
-//     This forces the developer to make an object inheriting such object to inherit the base object's implementation if 
-//     if it were to inherit its representation and vice versa.
+public:
 
-// (2) Strict 'IS-A' inheritance scheme is prone to combinatorial explosion. 
+  virtual ~Greeter (void) noexcept {
+  }
 
-// Solution:
+  virtual void Greet (void) const = 0;
+};
 
-// (*) Create a separate Interface/Abstract Class for the object representation and its implementation.
 
-// (*) Maintain a reference of an implementation class as a field in the representation class.
+class EnglishGreeter final : public Greeter {
 
-// (*) Keep the implementation members private and declare the base representation class as a friend of the base 
-//     implementation class.
+public:
 
-// (*) Separate inheritance trees can be built for both the implementation class and representation class.
+  virtual void Greet (void) const override {
 
-// (*) To reduce coupling of each implementation class derivative to its representation class, put all the elementary processing to
-//     inside the base implementation class so the representation class doesn't need to be aware of all the base implementation 
-//     class derivatives.
+    Output () << "Hello from a generic bridge.\n";
+  }
+};
 
-// Structure:
 
+class FrenchGreeter final : public Greeter {
 
-class BehaviourImplementation {
-  
-  friend class BaseObject;
+public:
 
-protected:
-  
-  BehaviourImplementation (void) {
-  }
-  
-  virtual ~BehaviourImplementation (void) noexcept {
+  virtual void Greet (void) const override {
+
+    Output () << "Bonjour from a generic bridge.\n";
   }
-  
-  virtual void BehaviourCalledBy (const std::string& executor_name) const = 0;
-  
-  
-  static BehaviourImplementation* CreateDefault (void);  
-  
-  static BehaviourImplementation* CreateFirst (void);
-  
-  static BehaviourImplementation* CreateSecond (void);
 };
 
 
-class Default : public BehaviourImplementation {
-  
-  friend class BehaviourImplementation;
-
-protected:
-  
-  Default (void)
-      
-      : BehaviourImplementation () {
-  }
-  
-  virtual ~Default (void) noexcept override {
-  }
-  
-  virtual void BehaviourCalledBy (const std::string& executor_name) const override {
-    
-    std::cout << "Default behaviour executed from " << executor_name << ".\n";
-  }
-};
+int main (int arg_count, char* arg_vector []) {
 
+  //Demo of Bridge Pattern:
 
-class First : public BehaviourImplementation {
-  
-  friend class BehaviourImplementation;
+  ObjectOne object_one;
 
-protected:
-  
-  First (void)
-      
-      : BehaviourImplementation () {
-  }
-  
-  virtual ~First (void) noexcept override {
-  }
-  
-  virtual void BehaviourCalledBy (const std::string& executor_name) const override {
-    
-    std::cout << "First behaviour executed from " << executor_name << ".\n";
-  }
-};
+  object_one.ExecuteBehaviour ();
 
+  object_one.SetBehaviour (BaseObject::Behaviour::First).ExecuteBehaviour ();
 
-class Second : public BehaviourImplementation  {
-  
-  friend class BehaviourImplementation;
+  object_one.SetBehaviour (BaseObject::Behaviour::Second).ExecuteBehaviour ();
 
-protected:
-  
-  Second (void)
-      
-      : BehaviourImplementation () {
-  }
-  
-  virtual ~Second (void) noexcept override {
-  }  
-  
-  virtual void BehaviourCalledBy (const std::string& executor_name) const override {
-    
-    std::cout << "Second behaviour executed from " << executor_name << ".\n";
-  }
-};
 
+  ObjectTwo object_two;
 
-BehaviourImplementation* BehaviourImplementation::CreateDefault (void) {
-  
-  return new Default ();
-}
+  object_two.ExecuteBehaviour ();
 
-BehaviourImplementation* BehaviourImplementation::CreateFirst (void) {
-  
-  return new First ();
-}
+  object_two.SetBehaviour (BaseObject::Behaviour::First).ExecuteBehaviour ();
 
-BehaviourImplementation* BehaviourImplementation::CreateSecond (void) {
-  
-  return new Second ();
-}
+  object_two.SetBehaviour (BaseObject::Behaviour::Second).ExecuteBehaviour ();
 
 
+  // Objects can be bucketed by behaviour and executed in batches:
 
-class BaseObject {
+  object_one.SetBehaviour (BaseObject::Behaviour::First);
 
-public:
-  
-  enum class Behaviour {Default, First, Second};
+  BehaviourBuckets buckets;
 
-  virtual ~BaseObject (void) noexcept {
-    
-    delete this->implementation;
-  }
-  
-  const BaseObject& SetBehaviour (const Behaviour& new_behaviour) {
-    
-    delete this->implementation;
-    
-    switch (new_behaviour) {
-      
-      case Behaviour::Default:
-        
-        this->implementation = BehaviourImplementation::CreateDefault ();
-        
-        break;
-      
-      case Behaviour::First:
-        
-        this->implementation = BehaviourImplementation::CreateFirst ();
-        
-        break;
-      
-      case Behaviour::Second:
-        
-        this->implementation = BehaviourImplementation::CreateSecond ();
-        
-        break;
-    }
-    
-    return *this;
-  }
-  
-  void ExecuteBehaviour (void) const {
-    
-    this->implementation->BehaviourCalledBy (this->name);
-  }
+  buckets.Add (object_one);
 
-protected:
-  
-  BaseObject (void) 
-      
-      : implementation (nullptr) {
-    
-    this->SetBehaviour (Behaviour::Default);
-  } 
-  
-  std::string name;
-
-private:
-  
-  BehaviourImplementation* implementation;
-};
+  buckets.Add (object_two);
 
+  buckets.ExecuteBehaviours ();
 
-class ObjectOne : public BaseObject {
 
-public:
-  
-  ObjectOne (void)
-      
-      : BaseObject () {
-    
-    this->name = "ObjectOne";
-  }
-  
-  virtual ~ObjectOne (void) noexcept override {
-  }
-};
+  // The behaviour can also be fixed at compile time:
 
+  StaticObjectOne<First> static_object_one;
 
-class ObjectTwo : public BaseObject {
+  static_object_one.ExecuteBehaviour ();
 
-public:
-  
-  ObjectTwo (void)
-      
-      : BaseObject () {
-    
-    this->name = "ObjectTwo";
-  }
-  
-  virtual ~ObjectTwo (void) noexcept override {
-  }
-};
+  StaticObjectTwo<Second> static_object_two;
 
-int main (int arg_count, char* arg_vector []) {
+  static_object_two.ExecuteBehaviour ();
 
-  //Demo of Bridge Pattern:
-  
-  ObjectOne object_one;
-  
-  object_one.ExecuteBehaviour ();
 
-  object_one.SetBehaviour (BaseObject::Behaviour::First).ExecuteBehaviour ();
+  // Any abstraction can be bridged to a closed set of its implementations, used through the abstraction or visited as the active type:
 
-  object_one.SetBehaviour (BaseObject::Behaviour::Second).ExecuteBehaviour ();
+  BasicBridge<Greeter, ImplementationSet<EnglishGreeter, FrenchGreeter>> greeter;
 
+  greeter->Greet ();
 
-  ObjectTwo object_two;
+  greeter.Set<FrenchGreeter> ();
 
-  object_two.ExecuteBehaviour ();
+  greeter.Visit ([] (const auto& active_greeter) { active_greeter.Greet (); });
 
-  object_two.SetBehaviour (BaseObject::Behaviour::First).ExecuteBehaviour ();
 
-  object_two.SetBehaviour (BaseObject::Behaviour::Second).ExecuteBehaviour ();
-  
-  
   return 0;
 }
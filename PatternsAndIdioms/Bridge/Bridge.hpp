@@ -0,0 +1,534 @@
+#ifndef BRIDGE_HPP
+#define BRIDGE_HPP
+
+#include <array>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "../Common/OutputSink.hpp"
+
+// Bridge Pattern Idiom.
+
+// Motivation:
+
+// (1) With typical class definitions, the object representation is usually hard-coupled with its implementation.
+//     This forces the developer to make an object inheriting such object to inherit the base object's implementation if
+//     if it were to inherit its representation and vice versa.
+
+// (2) Strict 'IS-A' inheritance scheme is prone to combinatorial explosion.
+
+// Solution:
+
+// (*) Create a separate Interface/Abstract Class for the object representation and its implementation.
+
+// (*) Maintain a reference of an implementation class as a field in the representation class.
+
+// (*) Keep the implementation members private and declare the base representation class as a friend of the base
+//     implementation class.
+
+// (*) Separate inheritance trees can be built for both the implementation class and representation class.
+
+// (*) To reduce coupling of each implementation class derivative to its representation class, put all the elementary processing to
+//     inside the base implementation class so the representation class doesn't need to be aware of all the base implementation
+//     class derivatives.
+
+// (*) Implementations that hold no state don't need one instance per representation. Each one exists exactly once, as an immutable
+//     static-lifetime flyweight, and every representation shares it; switching behaviour is then just a pointer store, with no
+//     allocation or deallocation.
+
+// (*) A representation that never switches behaviour at runtime doesn't need the indirection at all. Making the implementation a
+//     template parameter of the representation (a policy) binds it at compile time: the call is direct, so the compiler can inline
+//     the behaviour into the representation. The runtime-switchable representation stays for everything that does switch.
+
+// (*) When the set of implementations is closed (and Behaviour already enumerates it), the runtime-switchable representation doesn't
+//     need a pointer either. The representation delegates to a holder, and the holder can keep the active implementation inline in a
+//     std::variant and dispatch with std::visit instead of a vtable, so a representation allocates nothing and owns its behaviour by
+//     value. The flyweight holder is kept as VirtualBaseObject for comparison.
+
+// (*) Running the behaviour of a large number of objects one by one pays a dispatch per object, and a load from wherever each object
+//     happens to live. Sorting what the behaviours read into one contiguous bucket per behaviour, rebuilt on every tick, turns that
+//     into one call per bucket (on the shared flyweight) that runs the behaviour over the whole bucket in order.
+
+// (*) Everything above is written against one Behaviour hierarchy. BasicBridge.hpp applies the variant holder to any abstraction and
+//     closed set of implementations.
+
+// Structure:
+
+
+class BehaviourImplementation {
+
+  friend class FlyweightBehaviourHolder;
+
+  friend class BehaviourBuckets;
+
+protected:
+
+  BehaviourImplementation (void) {
+  }
+
+  virtual ~BehaviourImplementation (void) noexcept {
+  }
+
+  virtual void BehaviourCalledBy (const std::string& executor_name) const = 0;
+
+  // Runs the behaviour once for each of executor_count names laid out one after another.
+  virtual void BehaviourCalledBy (const std::string* executor_names, std::size_t executor_count) const = 0;
+
+
+  static const BehaviourImplementation* GetDefault (void);
+
+  static const BehaviourImplementation* GetFirst (void);
+
+  static const BehaviourImplementation* GetSecond (void);
+};
+
+
+class Default final : public BehaviourImplementation {
+
+  friend class VariantBehaviourHolder;
+
+  friend class BehaviourBuckets;
+
+  template <typename> friend class StaticBaseObject;
+
+public:
+
+  Default (void)
+
+      : BehaviourImplementation () {
+  }
+
+  virtual ~Default (void) noexcept override {
+  }
+
+protected:
+
+  virtual void BehaviourCalledBy (const std::string& executor_name) const override {
+
+    Output () << "Default behaviour executed from " << executor_name << ".\n";
+  }
+
+  virtual void BehaviourCalledBy (const std::string* executor_names, std::size_t executor_count) const override {
+
+    std::ostream& output = Output ();
+
+    for (std::size_t index = 0; index < executor_count; ++index) {
+
+      output << "Default behaviour executed from " << executor_names [index] << ".\n";
+    }
+  }
+};
+
+
+class First final : public BehaviourImplementation {
+
+  friend class VariantBehaviourHolder;
+
+  friend class BehaviourBuckets;
+
+  template <typename> friend class StaticBaseObject;
+
+public:
+
+  First (void)
+
+      : BehaviourImplementation () {
+  }
+
+  virtual ~First (void) noexcept override {
+  }
+
+protected:
+
+  virtual void BehaviourCalledBy (const std::string& executor_name) const override {
+
+    Output () << "First behaviour executed from " << executor_name << ".\n";
+  }
+
+  virtual void BehaviourCalledBy (const std::string* executor_names, std::size_t executor_count) const override {
+
+    std::ostream& output = Output ();
+
+    for (std::size_t index = 0; index < executor_count; ++index) {
+
+      output << "First behaviour executed from " << executor_names [index] << ".\n";
+    }
+  }
+};
+
+
+class Second final : public BehaviourImplementation {
+
+  friend class VariantBehaviourHolder;
+
+  friend class BehaviourBuckets;
+
+  template <typename> friend class StaticBaseObject;
+
+public:
+
+  Second (void)
+
+      : BehaviourImplementation () {
+  }
+
+  virtual ~Second (void) noexcept override {
+  }
+
+protected:
+
+  virtual void BehaviourCalledBy (const std::string& executor_name) const override {
+
+    Output () << "Second behaviour executed from " << executor_name << ".\n";
+  }
+
+  virtual void BehaviourCalledBy (const std::string* executor_names, std::size_t executor_count) const override {
+
+    std::ostream& output = Output ();
+
+    for (std::size_t index = 0; index < executor_count; ++index) {
+
+      output << "Second behaviour executed from " << executor_names [index] << ".\n";
+    }
+  }
+};
+
+
+inline const BehaviourImplementation* BehaviourImplementation::GetDefault (void) {
+
+  static const Default default_behaviour;
+
+  return &default_behaviour;
+}
+
+inline const BehaviourImplementation* BehaviourImplementation::GetFirst (void) {
+
+  static const First first_behaviour;
+
+  return &first_behaviour;
+}
+
+inline const BehaviourImplementation* BehaviourImplementation::GetSecond (void) {
+
+  static const Second second_behaviour;
+
+  return &second_behaviour;
+}
+
+
+
+enum class BehaviourKind {Default, First, Second};
+
+
+// Holds a pointer to one of the shared implementations and dispatches through its vtable.
+class FlyweightBehaviourHolder {
+
+public:
+
+  FlyweightBehaviourHolder (void)
+
+      : implementation (BehaviourImplementation::GetDefault ()) {
+  }
+
+  void Set (const BehaviourKind& new_behaviour) {
+
+    switch (new_behaviour) {
+
+      case BehaviourKind::Default:
+
+        this->implementation = BehaviourImplementation::GetDefault ();
+
+        break;
+
+      case BehaviourKind::First:
+
+        this->implementation = BehaviourImplementation::GetFirst ();
+
+        break;
+
+      case BehaviourKind::Second:
+
+        this->implementation = BehaviourImplementation::GetSecond ();
+
+        break;
+    }
+  }
+
+  void Execute (const std::string& executor_name) const {
+
+    this->implementation->BehaviourCalledBy (executor_name);
+  }
+
+  BehaviourKind Get (void) const {
+
+    if (this->implementation == BehaviourImplementation::GetFirst ()) {
+
+      return BehaviourKind::First;
+    }
+
+    if (this->implementation == BehaviourImplementation::GetSecond ()) {
+
+      return BehaviourKind::Second;
+    }
+
+    return BehaviourKind::Default;
+  }
+
+private:
+
+  const BehaviourImplementation* implementation;
+};
+
+
+// Holds the implementation itself, inline, and dispatches with std::visit. Every implementation is final, so each arm of the visit is
+// a direct call.
+class VariantBehaviourHolder {
+
+public:
+
+  VariantBehaviourHolder (void)
+
+      : implementation (std::in_place_type<Default>) {
+  }
+
+  void Set (const BehaviourKind& new_behaviour) {
+
+    switch (new_behaviour) {
+
+      case BehaviourKind::Default:
+
+        this->implementation.emplace<Default> ();
+
+        break;
+
+      case BehaviourKind::First:
+
+        this->implementation.emplace<First> ();
+
+        break;
+
+      case BehaviourKind::Second:
+
+        this->implementation.emplace<Second> ();
+
+        break;
+    }
+  }
+
+  void Execute (const std::string& executor_name) const {
+
+    std::visit ([&executor_name] (const auto& behaviour) { behaviour.BehaviourCalledBy (executor_name); }, this->implementation);
+  }
+
+  BehaviourKind Get (void) const {
+
+    // The alternatives are listed in the same order as BehaviourKind.
+    return static_cast<BehaviourKind> (this->implementation.index ());
+  }
+
+private:
+
+  std::variant<Default, First, Second> implementation;
+};
+
+
+template <typename BehaviourHolder>
+class BasicBaseObject {
+
+  friend class BehaviourBuckets;
+
+public:
+
+  using Behaviour = BehaviourKind;
+
+  virtual ~BasicBaseObject (void) noexcept {
+  }
+
+  const BasicBaseObject& SetBehaviour (const Behaviour& new_behaviour) {
+
+    this->implementation.Set (new_behaviour);
+
+    return *this;
+  }
+
+  void ExecuteBehaviour (void) const {
+
+    this->implementation.Execute (this->name);
+  }
+
+  Behaviour GetBehaviour (void) const {
+
+    return this->implementation.Get ();
+  }
+
+protected:
+
+  BasicBaseObject (void)
+
+      : implementation () {
+  }
+
+  std::string name;
+
+private:
+
+  BehaviourHolder implementation;
+};
+
+
+// Representations that switch behaviour through a pointer to a shared implementation and a virtual call.
+using VirtualBaseObject = BasicBaseObject<FlyweightBehaviourHolder>;
+
+// Representations that switch behaviour by storing the implementation inline in a std::variant.
+using BaseObject = BasicBaseObject<VariantBehaviourHolder>;
+
+
+class ObjectOne : public BaseObject {
+
+public:
+
+  ObjectOne (void)
+
+      : BaseObject () {
+
+    this->name = "ObjectOne";
+  }
+
+  virtual ~ObjectOne (void) noexcept override {
+  }
+};
+
+
+class ObjectTwo : public BaseObject {
+
+public:
+
+  ObjectTwo (void)
+
+      : BaseObject () {
+
+    this->name = "ObjectTwo";
+  }
+
+  virtual ~ObjectTwo (void) noexcept override {
+  }
+};
+
+
+// Objects grouped by their current behaviour, one bucket per behaviour holding a copy of what the behaviour reads from each object (its
+// name), contiguously. ExecuteBehaviours makes one call per bucket, on the shared flyweight, which runs its behaviour over the bucket in
+// order. An object whose behaviour or name changes keeps its old entry until the buckets are rebuilt: Clear them and Add every object
+// again on every tick. Clearing keeps the buckets' memory, so once they are warm rebuilding allocates nothing for names that fit in a
+// std::string's inline buffer.
+class BehaviourBuckets {
+
+public:
+
+  template <typename BehaviourHolder>
+  void Add (const BasicBaseObject<BehaviourHolder>& object) {
+
+    this->executor_names [static_cast<std::size_t> (object.GetBehaviour ())].push_back (object.name);
+  }
+
+  void Clear (void) {
+
+    for (auto& bucket : this->executor_names) {
+
+      bucket.clear ();
+    }
+  }
+
+  void ExecuteBehaviours (void) const {
+
+    this->ExecuteBucket (BehaviourKind::Default, static_cast<const Default*> (BehaviourImplementation::GetDefault ()));
+
+    this->ExecuteBucket (BehaviourKind::First, static_cast<const First*> (BehaviourImplementation::GetFirst ()));
+
+    this->ExecuteBucket (BehaviourKind::Second, static_cast<const Second*> (BehaviourImplementation::GetSecond ()));
+  }
+
+private:
+
+  // The flyweight's type is final, so the call is direct.
+  template <typename BehaviourType>
+  void ExecuteBucket (const BehaviourKind& bucket_behaviour, const BehaviourType* behaviour) const {
+
+    const std::vector<std::string>& bucket = this->executor_names [static_cast<std::size_t> (bucket_behaviour)];
+
+    if (!bucket.empty ()) {
+
+      behaviour->BehaviourCalledBy (bucket.data (), bucket.size ());
+    }
+  }
+
+  std::array<std::vector<std::string>, 3> executor_names;
+};
+
+
+template <typename BehaviourType>
+class StaticBaseObject {
+
+public:
+
+  virtual ~StaticBaseObject (void) noexcept {
+  }
+
+  void ExecuteBehaviour (void) const {
+
+    // Naming the type suppresses the virtual call.
+    this->implementation.BehaviourType::BehaviourCalledBy (this->name);
+  }
+
+protected:
+
+  StaticBaseObject (void)
+
+      : implementation () {
+  }
+
+  std::string name;
+
+private:
+
+  const BehaviourType implementation;
+};
+
+
+template <typename BehaviourType>
+class StaticObjectOne : public StaticBaseObject<BehaviourType> {
+
+public:
+
+  StaticObjectOne (void)
+
+      : StaticBaseObject<BehaviourType> () {
+
+    this->name = "ObjectOne";
+  }
+
+  virtual ~StaticObjectOne (void) noexcept override {
+  }
+};
+
+
+template <typename BehaviourType>
+class StaticObjectTwo : public StaticBaseObject<BehaviourType> {
+
+public:
+
+  StaticObjectTwo (void)
+
+      : StaticBaseObject<BehaviourType> () {
+
+    this->name = "ObjectTwo";
+  }
+
+  virtual ~StaticObjectTwo (void) noexcept override {
+  }
+};
+
+#endif
@@ -0,0 +1,252 @@
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "Bridge.hpp"
+#include "../Common/LifecycleBenchmarks.hpp"
+
+// Bridge Pattern Benchmarks.
+
+// Build: g++ -std=c++17 -O2 BridgeBenchmark.cpp -lbenchmark -lpthread
+
+// Toggle: every iteration switches the behaviour of every object in a collection, cycling through Default, First and Second. With the
+// flyweight holder each switch is a pointer store (it used to be a delete followed by a new); with the variant holder it is an emplace.
+
+// Dispatch: ExecuteBehaviour over a collection of objects that all run the First behaviour, through the flyweight holder (a virtual
+// call through the implementation pointer), the variant holder (std::visit over final implementations) and StaticBaseObject (a direct,
+// inlinable call). Output goes to a NullOutputSink while they run, so the dispatch is measured rather than the terminal.
+
+// Batch: hundreds of thousands of individually allocated ObjectOne/ObjectTwo instances with random behaviours, executed one by one
+// against once per behaviour bucket. The buckets are rebuilt in every iteration, as they would be on every tick, so sorting the objects
+// into them is timed along with running them.
+
+// Lifecycle: construction, copying, assignment, destruction and dispatch of ObjectOne through each holder and as StaticObjectOne, on
+// warm and cold batches from 1 to 8 threads (see LifecycleBenchmarks.hpp). StaticObjectOne holds its behaviour as a constant, so it
+// can't be assigned.
+
+
+// ObjectOne on top of the flyweight holder.
+class VirtualObjectOne : public VirtualBaseObject {
+
+public:
+
+  VirtualObjectOne (void)
+
+      : VirtualBaseObject () {
+
+    this->name = "ObjectOne";
+  }
+};
+
+
+template <typename Object>
+static void ToggleBehaviour (benchmark::State& state) {
+
+  const BehaviourKind behaviours [] = {BehaviourKind::Default, BehaviourKind::First, BehaviourKind::Second};
+
+  std::vector<Object> objects (state.range (0));
+
+  std::size_t next = 0;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      for (auto& object : objects) {
+
+        object.SetBehaviour (behaviours [next]);
+      }
+
+      next = (next + 1) % 3;
+
+      benchmark::ClobberMemory ();
+    }
+  }
+
+  state.SetItemsProcessed (state.iterations () * state.range (0));
+
+  ReportAllocations (state, state.iterations () * state.range (0));
+}
+
+BENCHMARK_TEMPLATE (ToggleBehaviour, VirtualObjectOne)->Arg (1 << 10)->Arg (1 << 20);
+
+BENCHMARK_TEMPLATE (ToggleBehaviour, ObjectOne)->Arg (1 << 10)->Arg (1 << 20);
+
+
+template <typename Object>
+static void ExecuteAll (benchmark::State& state, std::vector<Object>& objects) {
+
+  SilencedOutput silenced_output;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      for (const auto& object : objects) {
+
+        object.ExecuteBehaviour ();
+      }
+    }
+  }
+
+  state.SetItemsProcessed (state.iterations () * objects.size ());
+
+  ReportAllocations (state, state.iterations () * objects.size ());
+}
+
+static void BM_Dispatch_Virtual (benchmark::State& state) {
+
+  std::vector<VirtualObjectOne> objects (state.range (0));
+
+  for (auto& object : objects) {
+
+    object.SetBehaviour (BehaviourKind::First);
+  }
+
+  ExecuteAll (state, objects);
+}
+
+static void BM_Dispatch_Variant (benchmark::State& state) {
+
+  std::vector<ObjectOne> objects (state.range (0));
+
+  for (auto& object : objects) {
+
+    object.SetBehaviour (BehaviourKind::First);
+  }
+
+  ExecuteAll (state, objects);
+}
+
+static void BM_Dispatch_Template (benchmark::State& state) {
+
+  std::vector<StaticObjectOne<First>> objects (state.range (0));
+
+  ExecuteAll (state, objects);
+}
+
+BENCHMARK (BM_Dispatch_Virtual)->Arg (1 << 10)->Arg (1 << 20);
+
+BENCHMARK (BM_Dispatch_Variant)->Arg (1 << 10)->Arg (1 << 20);
+
+BENCHMARK (BM_Dispatch_Template)->Arg (1 << 10)->Arg (1 << 20);
+
+
+static std::vector<std::unique_ptr<BaseObject>> CreateMixedObjects (std::size_t object_count) {
+
+  const BehaviourKind behaviours [] = {BehaviourKind::Default, BehaviourKind::First, BehaviourKind::Second};
+
+  std::mt19937_64 random_engine (42);
+
+  std::vector<std::unique_ptr<BaseObject>> objects;
+
+  for (std::size_t index = 0; index < object_count; ++index) {
+
+    if (random_engine () % 2 == 0) {
+
+      objects.emplace_back (new ObjectOne ());
+    }
+    else {
+
+      objects.emplace_back (new ObjectTwo ());
+    }
+
+    objects.back ()->SetBehaviour (behaviours [random_engine () % 3]);
+  }
+
+  return objects;
+}
+
+static void BM_Batch_PerObject (benchmark::State& state) {
+
+  std::vector<std::unique_ptr<BaseObject>> objects = CreateMixedObjects (state.range (0));
+
+  SilencedOutput silenced_output;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      for (const auto& object : objects) {
+
+        object->ExecuteBehaviour ();
+      }
+    }
+  }
+
+  state.SetItemsProcessed (state.iterations () * state.range (0));
+
+  ReportAllocations (state, state.iterations () * state.range (0));
+}
+
+static void BM_Batch_Buckets (benchmark::State& state) {
+
+  std::vector<std::unique_ptr<BaseObject>> objects = CreateMixedObjects (state.range (0));
+
+  BehaviourBuckets buckets;
+
+  SilencedOutput silenced_output;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      buckets.Clear ();
+
+      for (const auto& object : objects) {
+
+        buckets.Add (*object);
+      }
+
+      buckets.ExecuteBehaviours ();
+    }
+  }
+
+  state.SetItemsProcessed (state.iterations () * state.range (0));
+
+  ReportAllocations (state, state.iterations () * state.range (0));
+}
+
+BENCHMARK (BM_Batch_PerObject)->Arg (1 << 18);
+
+BENCHMARK (BM_Batch_Buckets)->Arg (1 << 18);
+
+
+// Lifecycle suite (LifecycleBenchmarks.hpp).
+
+BENCHMARK_TEMPLATE (Construction, VirtualObjectOne)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Construction, ObjectOne)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Construction, StaticObjectOne<First>)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Copying, VirtualObjectOne)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Copying, ObjectOne)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Copying, StaticObjectOne<First>)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Assignment, VirtualObjectOne)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Assignment, ObjectOne)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Destruction, VirtualObjectOne)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Destruction, ObjectOne)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Destruction, StaticObjectOne<First>)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Dispatch, VirtualObjectOne)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Dispatch, ObjectOne)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Dispatch, StaticObjectOne<First>)->Apply (LifecycleRuns);
+
+
+BENCHMARK_MAIN ();
@@ -0,0 +1,144 @@
+#include <cassert>
+#include <sstream>
+
+#include "BasicBridge.hpp"
+#include "Bridge.hpp"
+
+
+// Keeps everything written through Output () while it is installed, for a single-threaded test to look at.
+class CapturedOutput : public OutputSink {
+
+public:
+
+  CapturedOutput (void)
+
+      : previous_output_sink (SetOutputSink (*this)) {
+  }
+
+  virtual ~CapturedOutput (void) noexcept override {
+
+    SetOutputSink (this->previous_output_sink);
+  }
+
+  virtual std::ostream& Stream (void) override {
+
+    return this->captured_stream;
+  }
+
+  virtual void Flush (void) override {
+  }
+
+  std::string Take (void) {
+
+    std::string captured_text = this->captured_stream.str ();
+
+    this->captured_stream.str ("");
+
+    return captured_text;
+  }
+
+private:
+
+  OutputSink& previous_output_sink;
+
+  std::ostringstream captured_stream;
+};
+
+
+class Greeter {
+
+public:
+
+  virtual ~Greeter (void) noexcept {
+  }
+
+  virtual int Greet (void) const = 0;
+};
+
+
+class EnglishGreeter final : public Greeter {
+
+public:
+
+  virtual int Greet (void) const override {
+
+    return 1;
+  }
+};
+
+
+class FrenchGreeter final : public Greeter {
+
+public:
+
+  virtual int Greet (void) const override {
+
+    return 2;
+  }
+};
+
+
+int main (void) {
+
+  // Representations start out with the Default behaviour and switch to whichever one is set; copies keep it.
+
+  ObjectOne object_one;
+
+  assert (object_one.GetBehaviour () == BehaviourKind::Default);
+
+  assert (object_one.SetBehaviour (BehaviourKind::First).GetBehaviour () == BehaviourKind::First);
+
+  ObjectTwo object_two;
+
+  object_two.SetBehaviour (BehaviourKind::Second);
+
+  ObjectOne object_one_copy (object_one);
+
+  assert (object_one_copy.GetBehaviour () == BehaviourKind::First);
+
+  object_one_copy.SetBehaviour (BehaviourKind::Default);
+
+  assert (object_one.GetBehaviour () == BehaviourKind::First);
+
+  // Buckets run every object once, bucket by bucket in the order of BehaviourKind, and can be cleared and refilled.
+
+  CapturedOutput captured_output;
+
+  BehaviourBuckets buckets;
+
+  buckets.Add (object_two);
+
+  buckets.Add (object_one);
+
+  buckets.Add (object_one_copy);
+
+  buckets.ExecuteBehaviours ();
+
+  assert (captured_output.Take () == "Default behaviour executed from ObjectOne.\n"
+                                     "First behaviour executed from ObjectOne.\n"
+                                     "Second behaviour executed from ObjectTwo.\n");
+
+  buckets.Clear ();
+
+  buckets.Add (object_two);
+
+  buckets.ExecuteBehaviours ();
+
+  assert (captured_output.Take () == "Second behaviour executed from ObjectTwo.\n");
+
+  // A generic bridge starts out with its first implementation and switches to the one set.
+
+  BasicBridge<Greeter, ImplementationSet<EnglishGreeter, FrenchGreeter>> greeter;
+
+  assert (greeter.Holds<EnglishGreeter> ());
+
+  assert (greeter->Greet () == 1);
+
+  greeter.Set<FrenchGreeter> ();
+
+  assert (greeter.Holds<FrenchGreeter> () && !greeter.Holds<EnglishGreeter> ());
+
+  assert (greeter.Visit ([] (const auto& active_greeter) { return active_greeter.Greet (); }) == 2);
+
+  return 0;
+}
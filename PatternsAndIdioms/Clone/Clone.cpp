@@ -1,122 +1,72 @@
-#include <iostream>
-#include <string>
+#include <memory_resource>
 
-// Clone Pattern.
+#include "Clone.hpp"
 
-// Motivation:
 
-// (1) Suppose you were in a position where you created a class inheritance hierarchy that all inherits from an abstract/interface base class
-//     and you decided to virtualize some base class methods intending to store the heap derived class instances to a pointer to the base class.
-//     Now, imagine a client code needing to create a copy of the object that the pointer to the base class is pointing to. Simply calling the
-//     new operator on the base class wouldn't work as this would create an instance of base class.
+int main (int arg_count, char* arg_vector []) {
 
-// (2) A solution to the above problem can be to create a virtual constructor (pretty much just a selector) on the base class and let the client
-//     code call 'Create' on the base class such that the base class creates the correct specified object. This CAN work, but is flawed as (1)
-//     the client code will need to be aware of the existence of the derived classes (unwanted coupling) and (2) you will need some sort of RTTI
-//     (run-time type identification) to distinguish the derived classes from each other.
+  // Demo of the Clone Pattern:
 
-// (Better) Solution:
+  // Store Two Objects of different type to a Base pointer:
 
-// (*) Define a virtual method called "Clone" ("Copy", "ProduceSimilarPopulationsOfGeneticallyIdenticalIndividualObjects", or anything really)
-//     such that the method has the following signature: Base_Class* Derived_class::Clone (void) const.
+  Base* first_base_object = new Base ("First");
 
-//     NOTE: Notice the const keyword? Although not necessary, it is a good practice to not modify any members of the invoking object as that
-//     is not well-defined through the name of the method. IF you really want such, please following a naming convention that reveals your
-//     true intentions, kind like: "CloneAndModifySomeShit" (not recommended).
+  Base* first_derived_object = new Derived ("First");
 
-// (*) The point of the Clone object is to return a copy of ITSELF through the use of shallow copy: return new derived_class (*this)
+  first_base_object->ExecuteBehaviour ();
 
-// (*) Make the all the derived classes override the Clone method such that an invocation of such method, even through the base class pointer,
-//     returns the specific copy of the object stored in the base class pointer.
+  first_derived_object->ExecuteBehaviour ();
 
-// Structure:
+  // Now perform the Clone Object:
 
-class Base {
+  Base* second_base_object = first_base_object->Clone ();
 
-public:
-  
-  explicit Base (const std::string& identifier) 
-      
-      : identifier (identifier) {
-  }
+  Base* second_derived_object = first_derived_object->Clone ();
 
-  virtual ~Base (void) noexcept {
-  }
+  second_base_object->ExecuteBehaviour ();
 
-  virtual Base* Clone (void) const {
-    
-    return new Base (*this);
-  }
+  second_derived_object->ExecuteBehaviour ();
 
-  virtual void ExecuteBehaviour (void) const {
-    
-    std::cout << this->identifier << " Base class behaviour is executed.\n";
-  }
 
-protected:
+  // Clone into an arena:
 
-  std::string identifier;
-};
+  std::pmr::monotonic_buffer_resource arena;
 
+  Base* third_base_object = first_base_object->Clone (arena);
 
+  Base* third_derived_object = first_derived_object->Clone (arena);
 
-class Derived : public Base {
+  third_base_object->ExecuteBehaviour ();
 
-public:
-  
-  explicit Derived (const std::string& identifier)
-      
-      : Base (identifier) {
-  }
+  third_derived_object->ExecuteBehaviour ();
 
-  virtual ~Derived (void) noexcept override {
-  }
 
-  virtual Base* Clone (void) const override {
-    return new Derived (*this);
-  }
+  // Stamp out several copies of one prototype in one call:
 
-  virtual void ExecuteBehaviour (void) const override {
-  
-    std::cout << this->identifier << " Derived Class behaviour is executed.\n";
-  }
-};
+  Base* fourth_derived_objects [3];
 
+  first_derived_object->CloneN (3, fourth_derived_objects, arena);
 
+  for (Base* fourth_derived_object : fourth_derived_objects) {
 
-int main (int arg_count, char* arg_vector []) {
-  
-  // Demo of the Clone Pattern:
-
-  // Store Two Objects of different type to a Base pointer:
-
-  Base* first_base_object = new Base ("First");
-
-  Base* first_derived_object = new Derived ("First");
-
-  first_base_object->ExecuteBehaviour ();
-
-  first_derived_object->ExecuteBehaviour ();
-  
-  // Now perform the Clone Object:
+    fourth_derived_object->ExecuteBehaviour ();
+  }
 
-  Base* second_base_object = first_base_object->Clone ();
 
-  Base* second_derived_object = first_derived_object->Clone ();
+  fourth_derived_objects [0]->DestroyN (3, arena);
 
-  second_base_object->ExecuteBehaviour ();
+  third_derived_object->Destroy (arena);
 
-  second_derived_object->ExecuteBehaviour ();
+  third_base_object->Destroy (arena);
 
-  
   delete second_derived_object;
-  
+
   delete second_base_object;
-  
+
   delete first_derived_object;
-  
+
   delete first_base_object;
 
 
   return 0;
-} 
+}
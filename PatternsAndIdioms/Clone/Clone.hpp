@@ -0,0 +1,278 @@
+#ifndef CLONE_HPP
+#define CLONE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <string>
+
+#include "../Common/AllocationTracking.hpp"
+#include "../Common/OutputSink.hpp"
+
+// Clone Pattern.
+
+// Motivation:
+
+// (1) Suppose you were in a position where you created a class inheritance hierarchy that all inherits from an abstract/interface base class
+//     and you decided to virtualize some base class methods intending to store the heap derived class instances to a pointer to the base class.
+//     Now, imagine a client code needing to create a copy of the object that the pointer to the base class is pointing to. Simply calling the
+//     new operator on the base class wouldn't work as this would create an instance of base class.
+
+// (2) A solution to the above problem can be to create a virtual constructor (pretty much just a selector) on the base class and let the client
+//     code call 'Create' on the base class such that the base class creates the correct specified object. This CAN work, but is flawed as (1)
+//     the client code will need to be aware of the existence of the derived classes (unwanted coupling) and (2) you will need some sort of RTTI
+//     (run-time type identification) to distinguish the derived classes from each other.
+
+// (Better) Solution:
+
+// (*) Define a virtual method called "Clone" ("Copy", "ProduceSimilarPopulationsOfGeneticallyIdenticalIndividualObjects", or anything really)
+//     such that the method has the following signature: Base_Class* Derived_class::Clone (void) const.
+
+//     NOTE: Notice the const keyword? Although not necessary, it is a good practice to not modify any members of the invoking object as that
+//     is not well-defined through the name of the method. IF you really want such, please following a naming convention that reveals your
+//     true intentions, kind like: "CloneAndModifySomeShit" (not recommended).
+
+// (*) The point of the Clone object is to return a copy of ITSELF through the use of shallow copy: return new derived_class (*this)
+
+// (*) Make the all the derived classes override the Clone method such that an invocation of such method, even through the base class pointer,
+//     returns the specific copy of the object stored in the base class pointer.
+
+// (*) Clone doesn't have to get its memory from the global heap. An overload that takes a std::pmr::memory_resource places the copy
+//     wherever the caller wants it: cloning a whole set of prototypes into one arena (std::pmr::monotonic_buffer_resource) costs a pointer
+//     bump per object, and the arena hands all of the memory back at once. A clone made this way is disposed of with Destroy, which runs
+//     its destructor and returns its memory to the same resource; members that allocate on their own (a long identifier) still use the
+//     global heap.
+
+// (*) Stamping out many copies of one prototype doesn't need a virtual call and an allocation per copy either. CloneN dispatches once,
+//     then builds all the copies as the concrete type in one contiguous block. Copies made this way are disposed of together, by calling
+//     DestroyN on the first one.
+
+// (*) Every derived class would have to repeat the same overrides with only the type name changed, so they are generated instead: a
+//     derived class inherits from Cloneable<Derived, Parent> (the Curiously Recurring Template Pattern), which implements them all in terms
+//     of the derived class's copy constructor.
+
+// Structure:
+
+class Base {
+
+public:
+
+  explicit Base (const std::string& identifier)
+
+      : identifier (identifier) {
+  }
+
+  virtual ~Base (void) noexcept {
+  }
+
+#ifdef CLEANCODE_TRACK_ALLOCATIONS
+  // Prototypes and the clones made by Clone () are allocated with new and deleted by whoever owns them, so both are counted here, with
+  // the size of the object's own type. The memory comes from the new/delete resource rather than straight from the global operators,
+  // which GCC would otherwise pair with the class's own operators and report as mismatched.
+  static void* operator new (std::size_t size) {
+
+    void* memory = std::pmr::new_delete_resource ()->allocate (size, alignof (std::max_align_t));
+
+    CLEANCODE_COUNT_ALLOCATION ("Clone", "Base::operator new", size);
+
+    return memory;
+  }
+
+  static void operator delete (void* memory, std::size_t size) noexcept {
+
+    CLEANCODE_COUNT_FREE ("Clone", "Base::operator delete", size);
+
+    std::pmr::new_delete_resource ()->deallocate (memory, size, alignof (std::max_align_t));
+  }
+#endif
+
+  virtual Base* Clone (void) const {
+
+    return new Base (*this);
+  }
+
+  virtual Base* Clone (std::pmr::memory_resource& memory_resource) const {
+
+    void* memory = memory_resource.allocate (sizeof (Base), alignof (Base));
+
+    CLEANCODE_COUNT_ALLOCATION ("Clone", "Base::Clone (memory_resource)", sizeof (Base));
+
+    try {
+
+      return ::new (memory) Base (*this);
+    }
+    catch (...) {
+
+      CLEANCODE_COUNT_FREE ("Clone", "Base::Clone (memory_resource)", sizeof (Base));
+
+      memory_resource.deallocate (memory, sizeof (Base), alignof (Base));
+
+      throw;
+    }
+  }
+
+  // Disposes of a clone made by Clone (memory_resource).
+  virtual void Destroy (std::pmr::memory_resource& memory_resource) {
+
+    CLEANCODE_COUNT_FREE ("Clone", "Base::Destroy", sizeof (Base));
+
+    this->~Base ();
+
+    memory_resource.deallocate (this, sizeof (Base), alignof (Base));
+  }
+
+  // Builds clone_count copies in one block taken from memory_resource and stores a pointer to each in destination. Throws
+  // std::bad_array_new_length, before allocating anything, if the block's size doesn't fit in a std::size_t.
+  virtual void CloneN (std::size_t clone_count, Base** destination, std::pmr::memory_resource& memory_resource) const {
+
+    Base::CloneBatch (*this, clone_count, destination, memory_resource);
+  }
+
+  // Disposes of the clone_count copies made by one CloneN; has to be called on the first of them.
+  virtual void DestroyN (std::size_t clone_count, std::pmr::memory_resource& memory_resource) {
+
+    Base::DestroyBatch (this, clone_count, memory_resource);
+  }
+
+  virtual void ExecuteBehaviour (void) const {
+
+    Output () << this->identifier << " Base class behaviour is executed.\n";
+  }
+
+protected:
+
+  template <typename Concrete>
+  static void CloneBatch (const Concrete& prototype, std::size_t clone_count, Base** destination,
+
+                          std::pmr::memory_resource& memory_resource) {
+
+    // The block's size would wrap around and come out too small for the copies written into it.
+    if (clone_count > SIZE_MAX / sizeof (Concrete)) {
+
+      throw std::bad_array_new_length ();
+    }
+
+    Concrete* clones = static_cast<Concrete*> (memory_resource.allocate (clone_count * sizeof (Concrete), alignof (Concrete)));
+
+    CLEANCODE_COUNT_ALLOCATION ("Clone", "Base::CloneBatch", clone_count * sizeof (Concrete));
+
+    std::size_t constructed_count = 0;
+
+    try {
+
+      for (; constructed_count < clone_count; ++constructed_count) {
+
+        destination [constructed_count] = ::new (clones + constructed_count) Concrete (prototype);
+      }
+    }
+    catch (...) {
+
+      std::destroy_n (clones, constructed_count);
+
+      CLEANCODE_COUNT_FREE ("Clone", "Base::CloneBatch", clone_count * sizeof (Concrete));
+
+      memory_resource.deallocate (clones, clone_count * sizeof (Concrete), alignof (Concrete));
+
+      throw;
+    }
+  }
+
+  template <typename Concrete>
+  static void DestroyBatch (Concrete* first, std::size_t clone_count, std::pmr::memory_resource& memory_resource) {
+
+    std::destroy_n (first, clone_count);
+
+    CLEANCODE_COUNT_FREE ("Clone", "Base::DestroyBatch", clone_count * sizeof (Concrete));
+
+    memory_resource.deallocate (first, clone_count * sizeof (Concrete), alignof (Concrete));
+  }
+
+  std::string identifier;
+};
+
+
+
+template <typename Concrete, typename Parent>
+class Cloneable : public Parent {
+
+public:
+
+  using Parent::Parent;
+
+  virtual Base* Clone (void) const override {
+
+    return new Concrete (this->GetConcrete ());
+  }
+
+  virtual Base* Clone (std::pmr::memory_resource& memory_resource) const override {
+
+    void* memory = memory_resource.allocate (sizeof (Concrete), alignof (Concrete));
+
+    CLEANCODE_COUNT_ALLOCATION ("Clone", "Cloneable::Clone (memory_resource)", sizeof (Concrete));
+
+    try {
+
+      return ::new (memory) Concrete (this->GetConcrete ());
+    }
+    catch (...) {
+
+      CLEANCODE_COUNT_FREE ("Clone", "Cloneable::Clone (memory_resource)", sizeof (Concrete));
+
+      memory_resource.deallocate (memory, sizeof (Concrete), alignof (Concrete));
+
+      throw;
+    }
+  }
+
+  virtual void Destroy (std::pmr::memory_resource& memory_resource) override {
+
+    CLEANCODE_COUNT_FREE ("Clone", "Cloneable::Destroy", sizeof (Concrete));
+
+    Concrete* concrete = static_cast<Concrete*> (this);
+
+    concrete->~Concrete ();
+
+    memory_resource.deallocate (concrete, sizeof (Concrete), alignof (Concrete));
+  }
+
+  virtual void CloneN (std::size_t clone_count, Base** destination, std::pmr::memory_resource& memory_resource) const override {
+
+    Base::CloneBatch (this->GetConcrete (), clone_count, destination, memory_resource);
+  }
+
+  virtual void DestroyN (std::size_t clone_count, std::pmr::memory_resource& memory_resource) override {
+
+    Base::DestroyBatch (static_cast<Concrete*> (this), clone_count, memory_resource);
+  }
+
+private:
+
+  const Concrete& GetConcrete (void) const {
+
+    return static_cast<const Concrete&> (*this);
+  }
+};
+
+
+
+class Derived : public Cloneable<Derived, Base> {
+
+public:
+
+  explicit Derived (const std::string& identifier)
+
+      : Cloneable (identifier) {
+  }
+
+  virtual ~Derived (void) noexcept override {
+  }
+
+  virtual void ExecuteBehaviour (void) const override {
+
+    Output () << this->identifier << " Derived Class behaviour is executed.\n";
+  }
+};
+
+#endif
@@ -0,0 +1,227 @@
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "Clone.hpp"
+#include "../Common/LifecycleBenchmarks.hpp"
+
+// Clone Pattern Benchmarks.
+
+// Build: g++ -std=c++17 -O2 CloneBenchmark.cpp -lbenchmark -lpthread
+
+// Bulk clone: a scene of 1M prototypes, half Base and half Derived in random order, is cloned and then disposed of in one iteration.
+
+// (*) Heap: Clone () and delete, one global allocation and deallocation per object.
+
+// (*) Arena: Clone (arena) into a std::pmr::monotonic_buffer_resource, Destroy (arena) per object to run the destructors, then one
+//     release for the whole scene.
+
+// Stamp: thousands of copies of one Derived prototype, one Clone per copy against a single CloneN, disposed of the same way.
+
+// Lifecycle: construction, copying, assignment, destruction, dispatch and Clone () of Base and Derived, on warm and cold batches from
+// 1 to 8 threads (see LifecycleBenchmarks.hpp).
+
+
+static std::vector<std::unique_ptr<Base>> CreatePrototypes (std::size_t prototype_count) {
+
+  std::mt19937_64 random_engine (42);
+
+  std::vector<std::unique_ptr<Base>> prototypes;
+
+  for (std::size_t index = 0; index < prototype_count; ++index) {
+
+    if (random_engine () % 2 == 0) {
+
+      prototypes.emplace_back (new Base ("Prototype"));
+    }
+    else {
+
+      prototypes.emplace_back (new Derived ("Prototype"));
+    }
+  }
+
+  return prototypes;
+}
+
+
+static void BM_BulkClone_Heap (benchmark::State& state) {
+
+  std::vector<std::unique_ptr<Base>> prototypes = CreatePrototypes (state.range (0));
+
+  std::vector<Base*> clones (prototypes.size ());
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      for (std::size_t index = 0; index < prototypes.size (); ++index) {
+
+        clones [index] = prototypes [index]->Clone ();
+      }
+
+      for (Base* clone : clones) {
+
+        delete clone;
+      }
+    }
+  }
+
+  state.SetItemsProcessed (state.iterations () * state.range (0));
+
+  ReportAllocations (state, state.iterations () * state.range (0));
+}
+
+static void BM_BulkClone_Arena (benchmark::State& state) {
+
+  std::vector<std::unique_ptr<Base>> prototypes = CreatePrototypes (state.range (0));
+
+  std::vector<Base*> clones (prototypes.size ());
+
+  std::pmr::monotonic_buffer_resource arena;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      for (std::size_t index = 0; index < prototypes.size (); ++index) {
+
+        clones [index] = prototypes [index]->Clone (arena);
+      }
+
+      for (Base* clone : clones) {
+
+        clone->Destroy (arena);
+      }
+
+      arena.release ();
+    }
+  }
+
+  state.SetItemsProcessed (state.iterations () * state.range (0));
+
+  ReportAllocations (state, state.iterations () * state.range (0));
+}
+
+BENCHMARK (BM_BulkClone_Heap)->Arg (1 << 20)->Unit (benchmark::kMillisecond);
+
+BENCHMARK (BM_BulkClone_Arena)->Arg (1 << 20)->Unit (benchmark::kMillisecond);
+
+
+static void BM_Stamp_CloneEach (benchmark::State& state) {
+
+  const Base& prototype = Derived ("Prototype");
+
+  std::vector<Base*> clones (state.range (0));
+
+  std::pmr::monotonic_buffer_resource arena;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      for (Base*& clone : clones) {
+
+        clone = prototype.Clone (arena);
+      }
+
+      for (Base* clone : clones) {
+
+        clone->Destroy (arena);
+      }
+
+      arena.release ();
+    }
+  }
+
+  state.SetItemsProcessed (state.iterations () * state.range (0));
+
+  ReportAllocations (state, state.iterations () * state.range (0));
+}
+
+static void BM_Stamp_CloneN (benchmark::State& state) {
+
+  const Base& prototype = Derived ("Prototype");
+
+  std::vector<Base*> clones (state.range (0));
+
+  std::pmr::monotonic_buffer_resource arena;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      prototype.CloneN (clones.size (), clones.data (), arena);
+
+      clones.front ()->DestroyN (clones.size (), arena);
+
+      arena.release ();
+    }
+  }
+
+  state.SetItemsProcessed (state.iterations () * state.range (0));
+
+  ReportAllocations (state, state.iterations () * state.range (0));
+}
+
+BENCHMARK (BM_Stamp_CloneEach)->Arg (1 << 12);
+
+BENCHMARK (BM_Stamp_CloneN)->Arg (1 << 12);
+
+
+// Lifecycle suite (LifecycleBenchmarks.hpp).
+
+// Base with a fixed identifier, so the suite can default construct it.
+class BasePrototype : public Base {
+
+public:
+
+  BasePrototype (void)
+
+      : Base ("Prototype") {
+  }
+};
+
+// Derived with a fixed identifier, so the suite can default construct it.
+class DerivedPrototype : public Derived {
+
+public:
+
+  DerivedPrototype (void)
+
+      : Derived ("Prototype") {
+  }
+};
+
+BENCHMARK_TEMPLATE (Construction, BasePrototype)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Construction, DerivedPrototype)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Copying, BasePrototype)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Copying, DerivedPrototype)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Assignment, BasePrototype)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Assignment, DerivedPrototype)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Destruction, BasePrototype)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Destruction, DerivedPrototype)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Dispatch, BasePrototype)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Dispatch, DerivedPrototype)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Cloning, BasePrototype)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Cloning, DerivedPrototype)->Apply (LifecycleRuns);
+
+
+BENCHMARK_MAIN ();
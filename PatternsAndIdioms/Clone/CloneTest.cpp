@@ -0,0 +1,78 @@
+#include <cassert>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <typeinfo>
+
+#include "Clone.hpp"
+
+
+int main (void) {
+
+  Base* base_object = new Base ("Base");
+
+  Base* derived_object = new Derived ("Derived");
+
+  // A clone has the dynamic type of its prototype, wherever its memory comes from.
+
+  Base* base_clone = base_object->Clone ();
+
+  Base* derived_clone = derived_object->Clone ();
+
+  assert (typeid (*base_clone) == typeid (Base));
+
+  assert (typeid (*derived_clone) == typeid (Derived));
+
+  assert (derived_clone != derived_object);
+
+  std::pmr::monotonic_buffer_resource arena;
+
+  Base* arena_clone = derived_object->Clone (arena);
+
+  assert (typeid (*arena_clone) == typeid (Derived));
+
+  // A batch is made of distinct copies of the prototype's dynamic type, laid out one after another.
+
+  Base* batch_clones [3];
+
+  derived_object->CloneN (3, batch_clones, arena);
+
+  for (Base* batch_clone : batch_clones) {
+
+    assert (typeid (*batch_clone) == typeid (Derived));
+  }
+
+  assert (static_cast<Derived*> (batch_clones [1]) == static_cast<Derived*> (batch_clones [0]) + 1);
+
+  assert (static_cast<Derived*> (batch_clones [2]) == static_cast<Derived*> (batch_clones [0]) + 2);
+
+  // A batch whose size doesn't fit in a std::size_t is refused before anything is allocated (the null resource would throw
+  // std::bad_alloc instead).
+
+  bool refused = false;
+
+  try {
+
+    derived_object->CloneN (SIZE_MAX / 2, batch_clones, *std::pmr::null_memory_resource ());
+  }
+  catch (const std::bad_array_new_length&) {
+
+    refused = true;
+  }
+
+  assert (refused);
+
+  batch_clones [0]->DestroyN (3, arena);
+
+  arena_clone->Destroy (arena);
+
+  delete derived_clone;
+
+  delete base_clone;
+
+  delete derived_object;
+
+  delete base_object;
+
+  return 0;
+}
@@ -0,0 +1,327 @@
+#ifndef ALLOCATION_HPP
+#define ALLOCATION_HPP
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "AllocationTracking.hpp"
+
+// Allocation Policies.
+
+// Where a body is allocated. Every policy provides Allocate<Body> () and Release<Body> (memory), for raw memory the size and alignment
+// of a Body:
+
+// (*) HeapAllocation goes to the global operator new and delete.
+
+// (*) SlabAllocation carves fixed-size blocks out of large slabs and recycles them through a free list, in one pool per block size and
+//     alignment shared by all threads.
+
+// (*) ThreadCachedSlabAllocation puts a thread-local cache in front of the pool, so each thread recycles its own blocks without taking
+//     the pool's lock. A thread whose cache is already gone (a body released from another thread-local's destructor) uses the pool
+//     directly.
+
+// (*) InlineAllocation allocates nothing; it marks bodies that live inside their handle.
+
+
+// Fixed-size blocks carved out of slabs and recycled through a free list. One pool exists per block size and alignment.
+template <std::size_t BlockSize, std::size_t BlockAlignment>
+class SlabPool {
+
+public:
+
+  union Block {
+
+    Block* next;
+
+    alignas (BlockAlignment) unsigned char storage [BlockSize];
+  };
+
+  static constexpr std::size_t blocks_per_slab = 1024;
+
+  static SlabPool& Shared (void) {
+
+    static SlabPool pool;
+
+    return pool;
+  }
+
+  void* Allocate (void) {
+
+    std::lock_guard<std::mutex> pool_guard (this->lock);
+
+    if (this->free_list == nullptr) {
+
+      this->AddSlab ();
+    }
+
+    Block* block = this->free_list;
+
+    this->free_list = block->next;
+
+    return block;
+  }
+
+  void Release (void* memory) noexcept {
+
+    std::lock_guard<std::mutex> pool_guard (this->lock);
+
+    Block* block = static_cast<Block*> (memory);
+
+    block->next = this->free_list;
+
+    this->free_list = block;
+  }
+
+  // Unlinks up to block_count blocks from the free list and returns them as a list of their own; acquired_count receives its length.
+  Block* AcquireBatch (std::size_t block_count, std::size_t& acquired_count) {
+
+    std::lock_guard<std::mutex> pool_guard (this->lock);
+
+    if (this->free_list == nullptr) {
+
+      this->AddSlab ();
+    }
+
+    Block* first = this->free_list;
+
+    Block* last = first;
+
+    for (acquired_count = 1; acquired_count < block_count && last->next != nullptr; ++acquired_count) {
+
+      last = last->next;
+    }
+
+    this->free_list = last->next;
+
+    last->next = nullptr;
+
+    return first;
+  }
+
+  // Links a list of blocks, first to last, back into the free list.
+  void ReleaseBatch (Block* first, Block* last) noexcept {
+
+    std::lock_guard<std::mutex> pool_guard (this->lock);
+
+    last->next = this->free_list;
+
+    this->free_list = first;
+  }
+
+private:
+
+  SlabPool (void)
+
+      : free_list (nullptr) {
+  }
+
+  void AddSlab (void) {
+
+    this->slabs.emplace_back (new Block [blocks_per_slab]);
+
+    CLEANCODE_COUNT_ALLOCATION ("Allocation", "SlabPool::AddSlab", sizeof (Block) * blocks_per_slab);
+
+    Block* slab = this->slabs.back ().get ();
+
+    for (std::size_t index = 0; index < blocks_per_slab; ++index) {
+
+      slab [index].next = (index + 1 < blocks_per_slab) ? &slab [index + 1] : this->free_list;
+    }
+
+    this->free_list = slab;
+  }
+
+  std::vector<std::unique_ptr<Block []>> slabs;
+
+  Block* free_list;
+
+  std::mutex lock;
+};
+
+
+// Per-thread free list in front of a SlabPool. Blocks move between the two in batches, so the pool's lock is only taken once every
+// cache_capacity / 2 allocations or releases.
+template <std::size_t BlockSize, std::size_t BlockAlignment>
+class ThreadCache {
+
+public:
+
+  using Pool = SlabPool<BlockSize, BlockAlignment>;
+
+  static constexpr std::size_t cache_capacity = 64;
+
+  static ThreadCache& Local (void) {
+
+    thread_local ThreadCache cache;
+
+    return cache;
+  }
+
+  // True once the calling thread has torn down its cache (another thread-local destructor may still allocate or release a body).
+  static bool& Destroyed (void) {
+
+    thread_local bool destroyed = false;
+
+    return destroyed;
+  }
+
+  void* Allocate (void) {
+
+    if (this->free_list == nullptr) {
+
+      this->free_list = Pool::Shared ().AcquireBatch (cache_capacity / 2, this->cached_blocks);
+    }
+
+    typename Pool::Block* block = this->free_list;
+
+    this->free_list = block->next;
+
+    --this->cached_blocks;
+
+    return block;
+  }
+
+  void Release (void* memory) noexcept {
+
+    typename Pool::Block* block = static_cast<typename Pool::Block*> (memory);
+
+    block->next = this->free_list;
+
+    this->free_list = block;
+
+    if (++this->cached_blocks > cache_capacity) {
+
+      this->ReturnBlocks (cache_capacity / 2);
+    }
+  }
+
+  ~ThreadCache (void) noexcept {
+
+    Destroyed () = true;
+
+    this->ReturnBlocks (this->cached_blocks);
+  }
+
+private:
+
+  ThreadCache (void)
+
+      : free_list (nullptr)
+
+      , cached_blocks (0) {
+  }
+
+  void ReturnBlocks (std::size_t block_count) noexcept {
+
+    if (block_count == 0) {
+
+      return;
+    }
+
+    typename Pool::Block* first = this->free_list;
+
+    typename Pool::Block* last = first;
+
+    for (std::size_t index = 1; index < block_count; ++index) {
+
+      last = last->next;
+    }
+
+    this->free_list = last->next;
+
+    this->cached_blocks -= block_count;
+
+    Pool::Shared ().ReleaseBatch (first, last);
+  }
+
+  typename Pool::Block* free_list;
+
+  std::size_t cached_blocks;
+};
+
+
+class HeapAllocation {
+
+public:
+
+  template <typename Body>
+  static void* Allocate (void) {
+
+    void* memory = ::operator new (sizeof (Body));
+
+    CLEANCODE_COUNT_ALLOCATION ("Allocation", "HeapAllocation::Allocate", sizeof (Body));
+
+    return memory;
+  }
+
+  template <typename Body>
+  static void Release (void* memory) noexcept {
+
+    CLEANCODE_COUNT_FREE ("Allocation", "HeapAllocation::Release", sizeof (Body));
+
+    ::operator delete (memory);
+  }
+};
+
+
+class SlabAllocation {
+
+public:
+
+  template <typename Body>
+  static void* Allocate (void) {
+
+    return SlabPool<sizeof (Body), alignof (Body)>::Shared ().Allocate ();
+  }
+
+  template <typename Body>
+  static void Release (void* memory) noexcept {
+
+    SlabPool<sizeof (Body), alignof (Body)>::Shared ().Release (memory);
+  }
+};
+
+
+class ThreadCachedSlabAllocation {
+
+public:
+
+  // Once the calling thread's cache is gone, blocks come from and go back to the pool itself.
+  template <typename Body>
+  static void* Allocate (void) {
+
+    using Cache = ThreadCache<sizeof (Body), alignof (Body)>;
+
+    if (Cache::Destroyed ()) {
+
+      return Cache::Pool::Shared ().Allocate ();
+    }
+
+    return Cache::Local ().Allocate ();
+  }
+
+  template <typename Body>
+  static void Release (void* memory) noexcept {
+
+    using Cache = ThreadCache<sizeof (Body), alignof (Body)>;
+
+    if (Cache::Destroyed ()) {
+
+      Cache::Pool::Shared ().Release (memory);
+
+      return;
+    }
+
+    Cache::Local ().Release (memory);
+  }
+};
+
+
+// The implementation lives inside the representation and is never allocated on its own.
+class InlineAllocation {
+};
+
+#endif
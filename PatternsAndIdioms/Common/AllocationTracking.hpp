@@ -0,0 +1,531 @@
+#ifndef ALLOCATION_TRACKING_HPP
+#define ALLOCATION_TRACKING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Allocation Tracking.
+
+// Counts the heap memory every idiom allocates and frees, so the cost of an operation can be read off rather than guessed:
+
+// (*) Tracking is opt-in. It is compiled in with CLEANCODE_TRACK_ALLOCATIONS defined (the CMake option of the same name); otherwise
+//     CLEANCODE_COUNT_ALLOCATION and CLEANCODE_COUNT_FREE expand to nothing, and their arguments are never evaluated.
+
+// (*) Every place an idiom calls new, delete, a memory resource or an allocator is a site, named after the idiom and the function it is
+//     in. A site counts its allocations, frees and their bytes. Its idiom counts them too, and also keeps its live and peak live bytes:
+//     memory is often freed at another site than the one that allocated it, so only the idiom as a whole knows how much is live. The
+//     policies in Common count under their own names (Allocation); a pooled block is only counted when its slab is.
+
+// (*) AllocationTracker::Idiom and Site query the counts, WriteJson dumps all of them. With CLEANCODE_ALLOCATION_REPORT set to a file
+//     name, that dump is also written at exit.
+
+// (*) AllocationTracker::ThisThread counts what the calling thread allocated and freed. The lifecycle benchmarks read it around their
+//     timed part and report allocations per operation next to the time, and so do the idioms' other benchmarks.
+
+// (*) Counts are relaxed atomics, updated in place: tracking costs a few read-modify-writes per allocation, which is noise next to the
+//     allocation but not next to an operation that allocates nothing. Timings of a tracked build are not comparable to untracked ones.
+
+
+// What was allocated and freed, at a site, in an idiom or on a thread. Live and peak live bytes are only kept for idioms.
+struct AllocationStatistics {
+
+  int64_t allocations = 0;
+
+  int64_t frees = 0;
+
+  int64_t allocated_bytes = 0;
+
+  int64_t freed_bytes = 0;
+
+  int64_t live_bytes = 0;
+
+  int64_t peak_live_bytes = 0;
+};
+
+
+class AllocationCounters {
+
+public:
+
+  AllocationCounters (void) = default;
+
+  AllocationCounters (const AllocationCounters&) = delete;
+
+  AllocationCounters& operator= (const AllocationCounters&) = delete;
+
+  void CountAllocation (int64_t bytes) noexcept {
+
+    this->allocations.fetch_add (1, std::memory_order_relaxed);
+
+    this->allocated_bytes.fetch_add (bytes, std::memory_order_relaxed);
+  }
+
+  void CountFree (int64_t bytes) noexcept {
+
+    this->frees.fetch_add (1, std::memory_order_relaxed);
+
+    this->freed_bytes.fetch_add (bytes, std::memory_order_relaxed);
+  }
+
+  AllocationStatistics Statistics (void) const noexcept {
+
+    AllocationStatistics statistics;
+
+    statistics.allocations = this->allocations.load (std::memory_order_relaxed);
+
+    statistics.frees = this->frees.load (std::memory_order_relaxed);
+
+    statistics.allocated_bytes = this->allocated_bytes.load (std::memory_order_relaxed);
+
+    statistics.freed_bytes = this->freed_bytes.load (std::memory_order_relaxed);
+
+    return statistics;
+  }
+
+  void Reset (void) noexcept {
+
+    this->allocations.store (0, std::memory_order_relaxed);
+
+    this->frees.store (0, std::memory_order_relaxed);
+
+    this->allocated_bytes.store (0, std::memory_order_relaxed);
+
+    this->freed_bytes.store (0, std::memory_order_relaxed);
+  }
+
+private:
+
+  std::atomic<int64_t> allocations {0};
+
+  std::atomic<int64_t> frees {0};
+
+  std::atomic<int64_t> allocated_bytes {0};
+
+  std::atomic<int64_t> freed_bytes {0};
+};
+
+
+// The counters of an idiom, which also follow how much of its memory is live.
+class IdiomAllocationCounters : public AllocationCounters {
+
+public:
+
+  void CountAllocation (int64_t bytes) noexcept {
+
+    AllocationCounters::CountAllocation (bytes);
+
+    int64_t live_bytes = this->live_bytes.fetch_add (bytes, std::memory_order_relaxed) + bytes;
+
+    int64_t peak_live_bytes = this->peak_live_bytes.load (std::memory_order_relaxed);
+
+    while (live_bytes > peak_live_bytes
+           && !this->peak_live_bytes.compare_exchange_weak (peak_live_bytes, live_bytes, std::memory_order_relaxed)) {
+    }
+  }
+
+  void CountFree (int64_t bytes) noexcept {
+
+    AllocationCounters::CountFree (bytes);
+
+    this->live_bytes.fetch_sub (bytes, std::memory_order_relaxed);
+  }
+
+  AllocationStatistics Statistics (void) const noexcept {
+
+    AllocationStatistics statistics = AllocationCounters::Statistics ();
+
+    statistics.live_bytes = this->live_bytes.load (std::memory_order_relaxed);
+
+    statistics.peak_live_bytes = this->peak_live_bytes.load (std::memory_order_relaxed);
+
+    return statistics;
+  }
+
+  // The peak starts over from what is live now; the live bytes themselves are kept, since that memory is still out there.
+  void Reset (void) noexcept {
+
+    AllocationCounters::Reset ();
+
+    this->peak_live_bytes.store (this->live_bytes.load (std::memory_order_relaxed), std::memory_order_relaxed);
+  }
+
+private:
+
+  std::atomic<int64_t> live_bytes {0};
+
+  std::atomic<int64_t> peak_live_bytes {0};
+};
+
+
+// One place an idiom allocates or frees memory. Sites register themselves on first use and are never unregistered.
+class AllocationSite {
+
+  friend class AllocationTracker;
+
+public:
+
+  AllocationSite (const char* idiom, const char* name);
+
+  AllocationSite (const AllocationSite&) = delete;
+
+  AllocationSite& operator= (const AllocationSite&) = delete;
+
+  void CountAllocation (std::size_t bytes) noexcept;
+
+  void CountFree (std::size_t bytes) noexcept;
+
+  const char* GetIdiom (void) const noexcept {
+
+    return this->idiom;
+  }
+
+  const char* GetName (void) const noexcept {
+
+    return this->name;
+  }
+
+  const AllocationCounters& GetCounters (void) const noexcept {
+
+    return this->counters;
+  }
+
+private:
+
+  const char* idiom;
+
+  const char* name;
+
+  AllocationCounters counters;
+
+  IdiomAllocationCounters* idiom_counters;
+};
+
+
+class AllocationTracker {
+
+public:
+
+#ifdef CLEANCODE_TRACK_ALLOCATIONS
+  static constexpr bool enabled = true;
+#else
+  static constexpr bool enabled = false;
+#endif
+
+  // Everything counted for the idiom so far.
+  static AllocationStatistics Idiom (const std::string& idiom) {
+
+    Registry& registry = GetRegistry ();
+
+    std::lock_guard<std::mutex> registry_guard (registry.lock);
+
+    for (const IdiomEntry& entry : registry.idioms) {
+
+      if (entry.name == idiom) {
+
+        return entry.counters->Statistics ();
+      }
+    }
+
+    return AllocationStatistics ();
+  }
+
+  // Everything counted at the site so far. A site in a template counts once per instantiation; the counts are added up here.
+  static AllocationStatistics Site (const std::string& idiom, const std::string& site) {
+
+    Registry& registry = GetRegistry ();
+
+    std::lock_guard<std::mutex> registry_guard (registry.lock);
+
+    AllocationStatistics statistics;
+
+    for (const AllocationSite* allocation_site : registry.sites) {
+
+      if (allocation_site->GetIdiom () == idiom && allocation_site->GetName () == site) {
+
+        Add (statistics, allocation_site->GetCounters ().Statistics ());
+      }
+    }
+
+    return statistics;
+  }
+
+  // Everything the calling thread allocated and freed so far, in any idiom.
+  static AllocationStatistics ThisThread (void) noexcept {
+
+    return ThreadStatistics ();
+  }
+
+  // Starts every site and idiom (and the calling thread) over. Memory allocated or freed while the counts are reset may go either way.
+  static void Reset (void) {
+
+    Registry& registry = GetRegistry ();
+
+    std::lock_guard<std::mutex> registry_guard (registry.lock);
+
+    for (IdiomEntry& entry : registry.idioms) {
+
+      entry.counters->Reset ();
+    }
+
+    for (AllocationSite* allocation_site : registry.sites) {
+
+      allocation_site->counters.Reset ();
+    }
+
+    ThreadStatistics () = AllocationStatistics ();
+  }
+
+  // Every idiom with its sites, as a JSON object.
+  static void WriteJson (std::ostream& stream) {
+
+    Registry& registry = GetRegistry ();
+
+    std::lock_guard<std::mutex> registry_guard (registry.lock);
+
+    stream << "{\n  \"idioms\": [";
+
+    for (std::size_t idiom_index = 0; idiom_index < registry.idioms.size (); ++idiom_index) {
+
+      const IdiomEntry& entry = registry.idioms [idiom_index];
+
+      stream << (idiom_index == 0 ? "\n" : ",\n") << "    {\n      \"name\": \"" << entry.name << "\",\n";
+
+      WriteCounts (stream, entry.counters->Statistics (), "      ", true);
+
+      stream << ",\n      \"sites\": [";
+
+      bool first_site = true;
+
+      for (const SiteEntry& site_entry : MergeSites (registry, entry.name)) {
+
+        stream << (first_site ? "\n" : ",\n") << "        {\n          \"name\": \"" << site_entry.name << "\",\n";
+
+        WriteCounts (stream, site_entry.statistics, "          ", false);
+
+        stream << "\n        }";
+
+        first_site = false;
+      }
+
+      stream << (first_site ? "]\n" : "\n      ]\n") << "    }";
+    }
+
+    stream << (registry.idioms.empty () ? "]\n" : "\n  ]\n") << "}\n";
+  }
+
+private:
+
+  friend class AllocationSite;
+
+  struct IdiomEntry {
+
+    std::string name;
+
+    std::unique_ptr<IdiomAllocationCounters> counters;
+  };
+
+  struct SiteEntry {
+
+    std::string name;
+
+    AllocationStatistics statistics;
+  };
+
+  struct Registry {
+
+    std::mutex lock;
+
+    std::vector<IdiomEntry> idioms;
+
+    std::vector<AllocationSite*> sites;
+  };
+
+  // Never destroyed, so sites can still count while statics are torn down at exit.
+  static Registry& GetRegistry (void) {
+
+    static Registry* registry = new Registry ();
+
+    return *registry;
+  }
+
+  static AllocationStatistics& ThreadStatistics (void) noexcept {
+
+    thread_local AllocationStatistics thread_statistics;
+
+    return thread_statistics;
+  }
+
+  static IdiomAllocationCounters* Register (AllocationSite* allocation_site) {
+
+    Registry& registry = GetRegistry ();
+
+    std::lock_guard<std::mutex> registry_guard (registry.lock);
+
+    registry.sites.push_back (allocation_site);
+
+    for (IdiomEntry& entry : registry.idioms) {
+
+      if (entry.name == allocation_site->GetIdiom ()) {
+
+        return entry.counters.get ();
+      }
+    }
+
+    registry.idioms.push_back (IdiomEntry {allocation_site->GetIdiom (), std::make_unique<IdiomAllocationCounters> ()});
+
+    return registry.idioms.back ().counters.get ();
+  }
+
+  // The idiom's sites, one entry per name, in the order they were first used.
+  static std::vector<SiteEntry> MergeSites (const Registry& registry, const std::string& idiom) {
+
+    std::vector<SiteEntry> site_entries;
+
+    for (const AllocationSite* allocation_site : registry.sites) {
+
+      if (allocation_site->GetIdiom () != idiom) {
+
+        continue;
+      }
+
+      SiteEntry* site_entry = nullptr;
+
+      for (SiteEntry& existing_entry : site_entries) {
+
+        if (existing_entry.name == allocation_site->GetName ()) {
+
+          site_entry = &existing_entry;
+
+          break;
+        }
+      }
+
+      if (site_entry == nullptr) {
+
+        site_entries.push_back (SiteEntry {allocation_site->GetName (), AllocationStatistics ()});
+
+        site_entry = &site_entries.back ();
+      }
+
+      Add (site_entry->statistics, allocation_site->GetCounters ().Statistics ());
+    }
+
+    return site_entries;
+  }
+
+  static void Add (AllocationStatistics& statistics, const AllocationStatistics& added_statistics) noexcept {
+
+    statistics.allocations += added_statistics.allocations;
+
+    statistics.frees += added_statistics.frees;
+
+    statistics.allocated_bytes += added_statistics.allocated_bytes;
+
+    statistics.freed_bytes += added_statistics.freed_bytes;
+  }
+
+  static void WriteCounts (std::ostream& stream, const AllocationStatistics& statistics, const char* indentation, bool with_live_bytes) {
+
+    stream << indentation << "\"allocations\": " << statistics.allocations << ",\n"
+
+        << indentation << "\"frees\": " << statistics.frees << ",\n"
+
+        << indentation << "\"allocated_bytes\": " << statistics.allocated_bytes << ",\n"
+
+        << indentation << "\"freed_bytes\": " << statistics.freed_bytes;
+
+    if (with_live_bytes) {
+
+      stream << ",\n" << indentation << "\"live_bytes\": " << statistics.live_bytes << ",\n"
+
+          << indentation << "\"peak_live_bytes\": " << statistics.peak_live_bytes;
+    }
+  }
+};
+
+
+inline AllocationSite::AllocationSite (const char* idiom, const char* name)
+
+    : idiom (idiom)
+
+    , name (name)
+
+    , idiom_counters (AllocationTracker::Register (this)) {
+}
+
+inline void AllocationSite::CountAllocation (std::size_t bytes) noexcept {
+
+  this->counters.CountAllocation (static_cast<int64_t> (bytes));
+
+  this->idiom_counters->CountAllocation (static_cast<int64_t> (bytes));
+
+  AllocationStatistics& thread_statistics = AllocationTracker::ThreadStatistics ();
+
+  ++thread_statistics.allocations;
+
+  thread_statistics.allocated_bytes += static_cast<int64_t> (bytes);
+}
+
+inline void AllocationSite::CountFree (std::size_t bytes) noexcept {
+
+  this->counters.CountFree (static_cast<int64_t> (bytes));
+
+  this->idiom_counters->CountFree (static_cast<int64_t> (bytes));
+
+  AllocationStatistics& thread_statistics = AllocationTracker::ThreadStatistics ();
+
+  ++thread_statistics.frees;
+
+  thread_statistics.freed_bytes += static_cast<int64_t> (bytes);
+}
+
+
+#ifdef CLEANCODE_TRACK_ALLOCATIONS
+
+// Writes the JSON dump to the file named by CLEANCODE_ALLOCATION_REPORT, if there is one, once the program exits.
+class AllocationReport {
+
+public:
+
+  ~AllocationReport (void) noexcept {
+
+    const char* report_file_name = std::getenv ("CLEANCODE_ALLOCATION_REPORT");
+
+    if (report_file_name == nullptr || *report_file_name == '\0') {
+
+      return;
+    }
+
+    std::ofstream report_file (report_file_name);
+
+    AllocationTracker::WriteJson (report_file);
+  }
+};
+
+inline AllocationReport allocation_report;
+
+// Every expansion is a site of its own, registered the first time it runs.
+#define CLEANCODE_ALLOCATION_SITE(idiom, site) \
+  ([] () -> AllocationSite& { static AllocationSite allocation_site (idiom, site); return allocation_site; } ())
+
+#define CLEANCODE_COUNT_ALLOCATION(idiom, site, bytes) CLEANCODE_ALLOCATION_SITE (idiom, site).CountAllocation (bytes)
+
+#define CLEANCODE_COUNT_FREE(idiom, site, bytes) CLEANCODE_ALLOCATION_SITE (idiom, site).CountFree (bytes)
+
+#else
+
+#define CLEANCODE_COUNT_ALLOCATION(idiom, site, bytes) static_cast<void> (0)
+
+#define CLEANCODE_COUNT_FREE(idiom, site, bytes) static_cast<void> (0)
+
+#endif
+
+#endif
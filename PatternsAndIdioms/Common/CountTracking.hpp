@@ -0,0 +1,531 @@
+#ifndef COUNT_TRACKING_HPP
+#define COUNT_TRACKING_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Count Tracking.
+
+// Counts the reference count traffic of the counted handles, so handles that are copied where they could have been moved or borrowed
+// show up in the numbers:
+
+// (*) Tracking is opt-in. It is compiled in with CLEANCODE_TRACK_COUNTS defined (the CMake option of the same name); otherwise the
+//     CLEANCODE_COUNT_* macros expand to nothing and TrackedCount, the base every counted body derives from, is empty.
+
+// (*) Every idiom counts its increments and decrements, the copies and moves of its handles, and their assignments: copy assignments,
+//     self-assignments (assigning a handle that already shares the body) and move assignments.
+
+// (*) Every body also keeps the highest count it was seen at: each increment samples the policy's own count (Sample, from Counting.hpp)
+//     and compares it with the body's peak, writing only when the peak grows. Once the policy reports the body's last release, the peak
+//     is filed into a histogram. A histogram full of ones means bodies that were never shared and didn't need counting at all.
+
+// (*) Counts are kept per thread, in records only their own thread writes to, and the peak is the only thing a body holds for tracking,
+//     so counting never adds a read-modify-write to a body, nor makes threads contend on anything the policy doesn't. CountTracker
+//     merges the records of all threads (and those of threads that are gone) when it is asked; WriteJson dumps the merged counts. With
+//     CLEANCODE_COUNT_REPORT set to a file name, that dump is also written at exit.
+
+
+enum class CountEvent {
+
+  increment,
+
+  decrement,
+
+  copy,
+
+  move,
+
+  assignment,
+
+  self_assignment,
+
+  move_assignment
+};
+
+
+// The merged counts of one idiom.
+struct CountStatistics {
+
+  static constexpr std::size_t event_count = 7;
+
+  // Bucket b holds the bodies whose highest count was at least 2^b and below 2^(b + 1).
+  static constexpr std::size_t peak_bucket_count = 32;
+
+  std::array<int64_t, event_count> events {};
+
+  std::array<int64_t, peak_bucket_count> peak_histogram {};
+
+  int64_t Count (CountEvent event) const noexcept {
+
+    return this->events [static_cast<std::size_t> (event)];
+  }
+
+  // Bodies whose last reference is gone.
+  int64_t ReleasedBodies (void) const noexcept {
+
+    int64_t released_bodies = 0;
+
+    for (int64_t bodies : this->peak_histogram) {
+
+      released_bodies += bodies;
+    }
+
+    return released_bodies;
+  }
+};
+
+
+#ifdef CLEANCODE_TRACK_COUNTS
+
+// The highest count a body was seen at. A copied body starts out unreferenced, like the copy itself.
+class TrackedCount {
+
+public:
+
+  TrackedCount (int64_t references = 0) noexcept
+
+      : peak_references (references) {
+  }
+
+  TrackedCount (const TrackedCount&) noexcept
+
+      : TrackedCount (0) {
+  }
+
+  TrackedCount& operator= (const TrackedCount&) = delete;
+
+  // A plain store, and only of a new peak: a body copied over and over at the same count is only ever read. Two increments that race
+  // may leave the lower of their samples behind, which a profile can live with.
+  void Observe (int64_t references) noexcept {
+
+    if (references > this->peak_references.load (std::memory_order_relaxed)) {
+
+      this->peak_references.store (references, std::memory_order_relaxed);
+    }
+  }
+
+  int64_t PeakReferences (void) const noexcept {
+
+    return this->peak_references.load (std::memory_order_relaxed);
+  }
+
+private:
+
+  std::atomic<int64_t> peak_references;
+};
+
+#else
+
+class TrackedCount {
+
+public:
+
+  TrackedCount (int64_t = 0) noexcept {
+  }
+};
+
+#endif
+
+
+class CountTracker {
+
+public:
+
+#ifdef CLEANCODE_TRACK_COUNTS
+  static constexpr bool enabled = true;
+#else
+  static constexpr bool enabled = false;
+#endif
+
+  // Idioms beyond this many are all counted under the last one.
+  static constexpr std::size_t max_idioms = 8;
+
+  // The index the idiom's counts are kept under, registering it the first time.
+  static std::size_t Register (const char* idiom) {
+
+    Registry& registry = GetRegistry ();
+
+    std::lock_guard<std::mutex> registry_guard (registry.lock);
+
+    for (std::size_t idiom_index = 0; idiom_index < registry.idiom_count; ++idiom_index) {
+
+      if (std::strcmp (registry.idioms [idiom_index], idiom) == 0) {
+
+        return idiom_index;
+      }
+    }
+
+    if (registry.idiom_count == max_idioms) {
+
+      return max_idioms - 1;
+    }
+
+    registry.idioms [registry.idiom_count] = idiom;
+
+    return registry.idiom_count++;
+  }
+
+  static void Count (std::size_t idiom_index, CountEvent event) noexcept {
+
+    Record (idiom_index, static_cast<std::size_t> (event), 0);
+  }
+
+  // The references are the policy's count right after the increment, as the policy's Sample sees it.
+  static void CountIncrement (std::size_t idiom_index, TrackedCount& tracked_count, int64_t references) noexcept {
+
+    Count (idiom_index, CountEvent::increment);
+
+#ifdef CLEANCODE_TRACK_COUNTS
+    tracked_count.Observe (references);
+#else
+    static_cast<void> (tracked_count);
+
+    static_cast<void> (references);
+#endif
+  }
+
+  // A copy assignment, of a handle that may already share the body.
+  static void CountAssignment (std::size_t idiom_index, bool same_body) noexcept {
+
+    Count (idiom_index, same_body ? CountEvent::self_assignment : CountEvent::assignment);
+  }
+
+  // Once per body, when the policy reports its last release and before the body is reclaimed.
+  static void CountRelease (std::size_t idiom_index, const TrackedCount& tracked_count) noexcept {
+
+#ifdef CLEANCODE_TRACK_COUNTS
+    Record (idiom_index, CountStatistics::event_count, PeakBucket (tracked_count.PeakReferences ()));
+#else
+    static_cast<void> (idiom_index);
+
+    static_cast<void> (tracked_count);
+#endif
+  }
+
+  // The counts of every thread, merged.
+  static CountStatistics Statistics (const std::string& idiom) {
+
+    Registry& registry = GetRegistry ();
+
+    std::lock_guard<std::mutex> registry_guard (registry.lock);
+
+    for (std::size_t idiom_index = 0; idiom_index < registry.idiom_count; ++idiom_index) {
+
+      if (registry.idioms [idiom_index] == idiom) {
+
+        return Merge (registry, idiom_index);
+      }
+    }
+
+    return CountStatistics ();
+  }
+
+  // Starts every count over. Counts made by other threads while this runs may survive it.
+  static void Reset (void) {
+
+    Registry& registry = GetRegistry ();
+
+    std::lock_guard<std::mutex> registry_guard (registry.lock);
+
+    Clear (registry.exited_threads);
+
+    for (ThreadCounts* thread_counts : registry.threads) {
+
+      Clear (*thread_counts);
+    }
+  }
+
+  // Every idiom's merged counts, as a JSON object.
+  static void WriteJson (std::ostream& stream) {
+
+    static constexpr const char* event_names [CountStatistics::event_count] = {
+
+        "increments", "decrements", "copies", "moves", "assignments", "self_assignments", "move_assignments"};
+
+    Registry& registry = GetRegistry ();
+
+    std::lock_guard<std::mutex> registry_guard (registry.lock);
+
+    stream << "{\n  \"idioms\": [";
+
+    for (std::size_t idiom_index = 0; idiom_index < registry.idiom_count; ++idiom_index) {
+
+      CountStatistics statistics = Merge (registry, idiom_index);
+
+      stream << (idiom_index == 0 ? "\n" : ",\n") << "    {\n      \"name\": \"" << registry.idioms [idiom_index] << "\",\n";
+
+      for (std::size_t event = 0; event < CountStatistics::event_count; ++event) {
+
+        stream << "      \"" << event_names [event] << "\": " << statistics.events [event] << ",\n";
+      }
+
+      stream << "      \"released_bodies\": " << statistics.ReleasedBodies () << ",\n      \"peak_count_histogram\": {";
+
+      bool first_bucket = true;
+
+      for (std::size_t bucket = 0; bucket < CountStatistics::peak_bucket_count; ++bucket) {
+
+        if (statistics.peak_histogram [bucket] == 0) {
+
+          continue;
+        }
+
+        int64_t lowest_peak = int64_t (1) << bucket;
+
+        stream << (first_bucket ? "\n" : ",\n") << "        \"" << lowest_peak;
+
+        if (lowest_peak > 1) {
+
+          stream << '-' << (2 * lowest_peak - 1);
+        }
+
+        stream << "\": " << statistics.peak_histogram [bucket];
+
+        first_bucket = false;
+      }
+
+      stream << (first_bucket ? "}\n" : "\n      }\n") << "    }";
+    }
+
+    stream << (registry.idiom_count == 0 ? "]\n" : "\n  ]\n") << "}\n";
+  }
+
+private:
+
+  // Per idiom: the events, then the peak histogram.
+  using IdiomCounts = std::array<std::atomic<int64_t>, CountStatistics::event_count + CountStatistics::peak_bucket_count>;
+
+  struct ThreadCounts {
+
+    std::array<IdiomCounts, max_idioms> counts {};
+  };
+
+  struct Registry {
+
+    std::mutex lock;
+
+    std::array<const char*, max_idioms> idioms {};
+
+    std::size_t idiom_count = 0;
+
+    std::vector<ThreadCounts*> threads;
+
+    // What threads that are gone counted.
+    ThreadCounts exited_threads;
+  };
+
+  // Registers the calling thread's counts for as long as it runs, and folds them into exited_threads once it is done.
+  struct ThreadRegistration {
+
+    ThreadRegistration (void) {
+
+      Registry& registry = GetRegistry ();
+
+      std::lock_guard<std::mutex> registry_guard (registry.lock);
+
+      registry.threads.push_back (&this->thread_counts);
+    }
+
+    ~ThreadRegistration (void) noexcept {
+
+      Registry& registry = GetRegistry ();
+
+      std::lock_guard<std::mutex> registry_guard (registry.lock);
+
+      Add (registry.exited_threads, this->thread_counts);
+
+      for (std::size_t index = 0; index < registry.threads.size (); ++index) {
+
+        if (registry.threads [index] == &this->thread_counts) {
+
+          registry.threads [index] = registry.threads.back ();
+
+          registry.threads.pop_back ();
+
+          break;
+        }
+      }
+
+      Destroyed () = true;
+    }
+
+    ThreadCounts thread_counts;
+  };
+
+  // Never destroyed, so threads can still fold their counts in while statics are torn down at exit.
+  static Registry& GetRegistry (void) {
+
+    static Registry* registry = new Registry ();
+
+    return *registry;
+  }
+
+  // True once the calling thread has torn down its counts; whatever it counts after that goes straight to exited_threads.
+  static bool& Destroyed (void) noexcept {
+
+    thread_local bool destroyed = false;
+
+    return destroyed;
+  }
+
+  // Only the owning thread writes to its counts, so a plain load and store is all an update takes.
+  static void Record (std::size_t idiom_index, std::size_t count_index, std::size_t offset) noexcept {
+
+    if (Destroyed ()) {
+
+      Registry& registry = GetRegistry ();
+
+      std::lock_guard<std::mutex> registry_guard (registry.lock);
+
+      std::atomic<int64_t>& count = registry.exited_threads.counts [idiom_index] [count_index + offset];
+
+      count.store (count.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+      return;
+    }
+
+    thread_local ThreadRegistration registration;
+
+    std::atomic<int64_t>& count = registration.thread_counts.counts [idiom_index] [count_index + offset];
+
+    count.store (count.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  // A peak below one can only come from a sample taken while other threads were changing the count; it is filed as a one.
+  static std::size_t PeakBucket (int64_t peak_references) noexcept {
+
+    std::size_t bucket = 0;
+
+    if (peak_references < 1) {
+
+      return bucket;
+    }
+
+    while (bucket + 1 < CountStatistics::peak_bucket_count && (peak_references >> (bucket + 1)) != 0) {
+
+      ++bucket;
+    }
+
+    return bucket;
+  }
+
+  static void Add (ThreadCounts& total_counts, const ThreadCounts& added_counts) noexcept {
+
+    for (std::size_t idiom_index = 0; idiom_index < max_idioms; ++idiom_index) {
+
+      for (std::size_t count_index = 0; count_index < total_counts.counts [idiom_index].size (); ++count_index) {
+
+        std::atomic<int64_t>& count = total_counts.counts [idiom_index] [count_index];
+
+        count.store (count.load (std::memory_order_relaxed) + added_counts.counts [idiom_index] [count_index].load (std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+      }
+    }
+  }
+
+  static void Clear (ThreadCounts& thread_counts) noexcept {
+
+    for (IdiomCounts& idiom_counts : thread_counts.counts) {
+
+      for (std::atomic<int64_t>& count : idiom_counts) {
+
+        count.store (0, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  static CountStatistics Merge (const Registry& registry, std::size_t idiom_index) {
+
+    CountStatistics statistics;
+
+    auto add_idiom_counts = [&] (const ThreadCounts& thread_counts) {
+
+      const IdiomCounts& idiom_counts = thread_counts.counts [idiom_index];
+
+      for (std::size_t event = 0; event < CountStatistics::event_count; ++event) {
+
+        statistics.events [event] += idiom_counts [event].load (std::memory_order_relaxed);
+      }
+
+      for (std::size_t bucket = 0; bucket < CountStatistics::peak_bucket_count; ++bucket) {
+
+        statistics.peak_histogram [bucket] += idiom_counts [CountStatistics::event_count + bucket].load (std::memory_order_relaxed);
+      }
+    };
+
+    add_idiom_counts (registry.exited_threads);
+
+    for (const ThreadCounts* thread_counts : registry.threads) {
+
+      add_idiom_counts (*thread_counts);
+    }
+
+    return statistics;
+  }
+};
+
+
+#ifdef CLEANCODE_TRACK_COUNTS
+
+// Writes the JSON dump to the file named by CLEANCODE_COUNT_REPORT, if there is one, once the program exits.
+class CountReport {
+
+public:
+
+  ~CountReport (void) noexcept {
+
+    const char* report_file_name = std::getenv ("CLEANCODE_COUNT_REPORT");
+
+    if (report_file_name == nullptr || *report_file_name == '\0') {
+
+      return;
+    }
+
+    std::ofstream report_file (report_file_name);
+
+    CountTracker::WriteJson (report_file);
+  }
+};
+
+inline CountReport count_report;
+
+// The idiom is registered the first time each expansion runs.
+#define CLEANCODE_COUNT_IDIOM(idiom) \
+  ([] () -> std::size_t { static std::size_t idiom_index = CountTracker::Register (idiom); return idiom_index; } ())
+
+#define CLEANCODE_COUNT_EVENT(idiom, event) CountTracker::Count (CLEANCODE_COUNT_IDIOM (idiom), CountEvent::event)
+
+#define CLEANCODE_COUNT_ASSIGNMENT(idiom, same_body) CountTracker::CountAssignment (CLEANCODE_COUNT_IDIOM (idiom), same_body)
+
+// The references are only evaluated with tracking compiled in, so sampling the policy's count costs nothing otherwise.
+#define CLEANCODE_COUNT_INCREMENT(idiom, tracked_count, references) \
+  CountTracker::CountIncrement (CLEANCODE_COUNT_IDIOM (idiom), tracked_count, references)
+
+#define CLEANCODE_COUNT_DECREMENT(idiom) CountTracker::Count (CLEANCODE_COUNT_IDIOM (idiom), CountEvent::decrement)
+
+#define CLEANCODE_COUNT_RELEASE(idiom, tracked_count) CountTracker::CountRelease (CLEANCODE_COUNT_IDIOM (idiom), tracked_count)
+
+#else
+
+#define CLEANCODE_COUNT_EVENT(idiom, event) static_cast<void> (0)
+
+#define CLEANCODE_COUNT_ASSIGNMENT(idiom, same_body) static_cast<void> (0)
+
+#define CLEANCODE_COUNT_INCREMENT(idiom, tracked_count, references) static_cast<void> (0)
+
+#define CLEANCODE_COUNT_DECREMENT(idiom) static_cast<void> (0)
+
+#define CLEANCODE_COUNT_RELEASE(idiom, tracked_count) static_cast<void> (0)
+
+#endif
+
+#endif
@@ -0,0 +1,713 @@
+#ifndef COUNTING_HPP
+#define COUNTING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+// Counting Policies.
+
+// How the counted bodies update their reference counts. Every policy provides a Counter type and:
+
+// (*) Increment and Decrement; Decrement returns true if the released reference was the last one.
+
+// (*) IsShared, true if more than one reference holds the body (a policy may err on the side of true).
+
+// (*) IncrementIfNonZero, which adds a reference unless the count already reached zero (weak representations lock through it).
+
+// (*) Sample, the count as the calling thread can see it without writing anything. It may be off while other threads change the count,
+//     and only count tracking (CountTracking.hpp) reads it.
+
+// (*) Bind, which tells the counter which body it counts and how to reclaim it. Only counters that can find out about the last release
+//     somewhere else than in a call to Decrement need it; for the others it does nothing.
+
+// (*) thread_safe, true if the count may be updated from several threads at once.
+
+// (*) WeakCounting, the policy weak counts are kept with next to a count of this policy: the policy itself, unless it only pays for
+//     counts that many threads update at once.
+
+
+class SingleThreadedCounting {
+
+public:
+
+  using Counter = int64_t;
+
+  static constexpr bool thread_safe = false;
+
+  using WeakCounting = SingleThreadedCounting;
+
+  static void Increment (Counter& counter) noexcept {
+
+    ++counter;
+  }
+
+  static bool Decrement (Counter& counter) noexcept {
+
+    return --counter <= 0;
+  }
+
+  static bool IsShared (const Counter& counter) noexcept {
+
+    return counter > 1;
+  }
+
+  static bool IncrementIfNonZero (Counter& counter) noexcept {
+
+    if (counter == 0) {
+
+      return false;
+    }
+
+    ++counter;
+
+    return true;
+  }
+
+  static int64_t Sample (const Counter& counter) noexcept {
+
+    return counter;
+  }
+
+  static void Bind (Counter&, void*, void (*) (void*)) noexcept {
+  }
+};
+
+
+class AtomicCounting {
+
+public:
+
+  using Counter = std::atomic<int64_t>;
+
+  static constexpr bool thread_safe = true;
+
+  using WeakCounting = AtomicCounting;
+
+  static void Increment (Counter& counter) noexcept {
+
+    counter.fetch_add (1, std::memory_order_relaxed);
+  }
+
+  // Acquire-release rather than release followed by an acquire fence on the last decrement: it costs the same on common hardware, and
+  // thread sanitizers understand it.
+  static bool Decrement (Counter& counter) noexcept {
+
+    return counter.fetch_sub (1, std::memory_order_acq_rel) == 1;
+  }
+
+  // A count of one can't go up behind the caller's back, since the only reference to copy from is the caller's own; the acquire pairs
+  // with the release of the decrements that brought it down.
+  static bool IsShared (const Counter& counter) noexcept {
+
+    return counter.load (std::memory_order_acquire) > 1;
+  }
+
+  static bool IncrementIfNonZero (Counter& counter) noexcept {
+
+    int64_t count = counter.load (std::memory_order_relaxed);
+
+    do {
+
+      if (count == 0) {
+
+        return false;
+      }
+    } while (!counter.compare_exchange_weak (count, count + 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+    return true;
+  }
+
+  static int64_t Sample (const Counter& counter) noexcept {
+
+    return counter.load (std::memory_order_relaxed);
+  }
+
+  static void Bind (Counter&, void*, void (*) (void*)) noexcept {
+  }
+};
+
+
+// Biased reference counting: a body is owned by the thread that created it. The owner counts its references in a plain integer, every
+// other thread counts in an atomic shared count, and the body is alive as long as the two add up to more than zero.
+
+// (*) While the owner still holds biased references, the shared count may go negative: a reference the owner counted can be released
+//     on another thread. The first thread that takes it below zero queues the counter with the owner, which merges it (adds its biased
+//     count to the shared one) the next time it updates any count, or when it exits. Once the owner exits, queued counters are merged
+//     by whoever queues them.
+
+// (*) When the owner releases its last biased reference it merges the counter on the spot. From then on, every thread, the owner
+//     included, counts in the shared count, and the release that takes a merged count to zero is the last one.
+
+// (*) A counter that is merged from a queue may turn out to be at zero, with nobody in a position to return true from Decrement; that
+//     is why the counter has to be bound to its body and to the function that reclaims it.
+
+// (*) Each thread that ever owned a body leaves a small record behind (the counters it owned may outlive it), which is never freed.
+class BiasedCounting {
+
+  struct Owner;
+
+public:
+
+  static constexpr bool thread_safe = true;
+
+  using WeakCounting = BiasedCounting;
+
+  class Counter {
+
+  public:
+
+    Counter (int64_t initial_count)
+
+        : owner (LocalOwner ())
+
+        , biased_count ((this->owner != nullptr) ? initial_count : 0)
+
+        , shared_word ((this->owner != nullptr) ? 0 : initial_count * count_unit + merged_flag)
+
+        , next_queued (nullptr)
+
+        , body (nullptr)
+
+        , reclaim (nullptr) {
+    }
+
+    Counter (const Counter&) = delete;
+
+    Counter& operator= (const Counter&) = delete;
+
+  private:
+
+    friend class BiasedCounting;
+
+    Owner* owner;
+
+    // Owner thread only.
+    int64_t biased_count;
+
+    // The shared count, shifted left by two, under the merged and queued flags.
+    std::atomic<int64_t> shared_word;
+
+    Counter* next_queued;
+
+    void* body;
+
+    void (*reclaim) (void*);
+  };
+
+  static void Increment (Counter& counter) noexcept {
+
+    Owner* owner = LocalOwner ();
+
+    if (owner != nullptr) {
+
+      DrainQueue (owner);
+    }
+
+    if (owner != nullptr && counter.owner == owner) {
+
+      // A biased count at zero is either a fresh counter or a merged one; only the owner ever merges while it is alive.
+      if (counter.biased_count > 0 || (counter.shared_word.load (std::memory_order_relaxed) & merged_flag) == 0) {
+
+        ++counter.biased_count;
+
+        return;
+      }
+    }
+
+    counter.shared_word.fetch_add (count_unit, std::memory_order_relaxed);
+  }
+
+  static bool Decrement (Counter& counter) noexcept {
+
+    Owner* owner = LocalOwner ();
+
+    // Merging queued counters first keeps the biased counts current.
+    if (owner != nullptr) {
+
+      DrainQueue (owner);
+    }
+
+    if (owner != nullptr && counter.owner == owner && counter.biased_count > 0) {
+
+      if (--counter.biased_count > 0) {
+
+        return false;
+      }
+
+      int64_t word = counter.shared_word.fetch_add (merged_flag, std::memory_order_acq_rel) + merged_flag;
+
+      return IsReleased (word);
+    }
+
+    int64_t word = counter.shared_word.fetch_sub (count_unit, std::memory_order_acq_rel) - count_unit;
+
+    if ((word & merged_flag) != 0) {
+
+      return IsReleased (word);
+    }
+
+    if ((word >> 2) < 0 && (word & queued_flag) == 0) {
+
+      if ((counter.shared_word.fetch_or (queued_flag, std::memory_order_acq_rel) & queued_flag) == 0) {
+
+        Queue (counter);
+      }
+    }
+
+    return false;
+  }
+
+  // Only the owner can see the biased count; any other thread assumes an unmerged body is shared.
+  static bool IsShared (const Counter& counter) noexcept {
+
+    int64_t word = counter.shared_word.load (std::memory_order_acquire);
+
+    if ((word & merged_flag) != 0) {
+
+      return (word >> 2) > 1;
+    }
+
+    Owner* owner = LocalOwner ();
+
+    if (owner == nullptr || counter.owner != owner) {
+
+      return true;
+    }
+
+    return counter.biased_count + (word >> 2) > 1;
+  }
+
+  // An unmerged body hasn't been found dead yet, so a reference can always be added to it (and keeps it from being found dead).
+  static bool IncrementIfNonZero (Counter& counter) noexcept {
+
+    Owner* owner = LocalOwner ();
+
+    if (owner != nullptr) {
+
+      DrainQueue (owner);
+    }
+
+    if (owner != nullptr && counter.owner == owner && counter.biased_count > 0) {
+
+      ++counter.biased_count;
+
+      return true;
+    }
+
+    int64_t word = counter.shared_word.load (std::memory_order_relaxed);
+
+    do {
+
+      if ((word & merged_flag) != 0 && (word >> 2) == 0) {
+
+        return false;
+      }
+    } while (!counter.shared_word.compare_exchange_weak (word, word + count_unit, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+    return true;
+  }
+
+  // The owner adds its biased count to the shared one; any other thread only sees the shared count, which falls short of the real one
+  // until the counter is merged.
+  static int64_t Sample (const Counter& counter) noexcept {
+
+    int64_t shared_count = counter.shared_word.load (std::memory_order_relaxed) >> 2;
+
+    Owner* owner = LocalOwner ();
+
+    if (owner != nullptr && counter.owner == owner) {
+
+      return counter.biased_count + shared_count;
+    }
+
+    return shared_count;
+  }
+
+  static void Bind (Counter& counter, void* body, void (*reclaim) (void*)) noexcept {
+
+    counter.body = body;
+
+    counter.reclaim = reclaim;
+  }
+
+private:
+
+  static constexpr int64_t merged_flag = 1;
+
+  static constexpr int64_t queued_flag = 2;
+
+  static constexpr int64_t count_unit = 4;
+
+  struct Owner {
+
+    std::atomic<Counter*> queued_head {nullptr};
+
+    std::atomic<bool> exited {false};
+
+    Owner* next_owner = nullptr;
+  };
+
+  struct OwnerRegistration {
+
+    OwnerRegistration (void)
+
+        : owner (new Owner ()) {
+
+      // Keeps every record reachable; they are never freed.
+      static std::atomic<Owner*> owners {nullptr};
+
+      this->owner->next_owner = owners.load (std::memory_order_relaxed);
+
+      while (!owners.compare_exchange_weak (this->owner->next_owner, this->owner, std::memory_order_release, std::memory_order_relaxed)) {
+      }
+    }
+
+    ~OwnerRegistration (void) noexcept {
+
+      RegistrationDestroyed () = true;
+
+      this->owner->exited.store (true, std::memory_order_seq_cst);
+
+      DrainQueue (this->owner);
+    }
+
+    Owner* owner;
+  };
+
+  // The calling thread's record, or nullptr once the thread has torn it down (it then counts like any other thread).
+  static Owner* LocalOwner (void) {
+
+    if (RegistrationDestroyed ()) {
+
+      return nullptr;
+    }
+
+    thread_local OwnerRegistration registration;
+
+    return registration.owner;
+  }
+
+  static bool& RegistrationDestroyed (void) {
+
+    thread_local bool destroyed = false;
+
+    return destroyed;
+  }
+
+  // Merged, at zero, and not waiting in a queue (whoever merges a queued counter decides for it).
+  static bool IsReleased (int64_t word) noexcept {
+
+    return (word & queued_flag) == 0 && (word >> 2) == 0;
+  }
+
+  static void Queue (Counter& counter) noexcept {
+
+    Owner* owner = counter.owner;
+
+    counter.next_queued = owner->queued_head.load (std::memory_order_relaxed);
+
+    while (!owner->queued_head.compare_exchange_weak (counter.next_queued, &counter, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+    }
+
+    // Either the owner's exit drain sees the counter, or this thread sees the owner gone and drains it itself.
+    if (owner->exited.load (std::memory_order_seq_cst)) {
+
+      DrainQueue (owner);
+    }
+  }
+
+  // Merges every queued counter of an owner: the owner itself, or any thread once the owner has exited.
+  static void DrainQueue (Owner* owner) noexcept {
+
+    // Sequentially consistent, so that an exiting owner can't miss a counter queued by a thread that didn't see it exit.
+    if (owner->queued_head.load (std::memory_order_seq_cst) == nullptr) {
+
+      return;
+    }
+
+    Counter* counter = owner->queued_head.exchange (nullptr, std::memory_order_acq_rel);
+
+    while (counter != nullptr) {
+
+      Counter* next = counter->next_queued;
+
+      int64_t merge = counter->biased_count * count_unit - queued_flag;
+
+      if ((counter->shared_word.load (std::memory_order_relaxed) & merged_flag) == 0) {
+
+        merge += merged_flag;
+      }
+
+      counter->biased_count = 0;
+
+      int64_t word = counter->shared_word.fetch_add (merge, std::memory_order_acq_rel) + merge;
+
+      if ((word >> 2) == 0) {
+
+        counter->reclaim (counter->body);
+      }
+
+      counter = next;
+    }
+  }
+};
+
+
+// Sharded counting: the count is spread over cache-line-padded slots plus a central count. Every thread counts in a slot of its own
+// (as long as there are no more threads than slots), so threads that all copy and destroy references to the same body never fight over
+// a cache line. No slot knows whether the count is zero; only the sum does.
+
+// (*) While the counter is sharded, the central count holds a large bias on top of the references it was created with, and its
+//     unbiased part never drops below one, so the sum can't reach zero behind anyone's back. Slots never go below zero either.
+
+// (*) A release on a slot that holds nothing (the reference was taken on another thread, or counted centrally) takes it from the central
+//     count instead. Handing references from a producer thread to a consumer thread only moves the count from the producer's slot to
+//     the central count, and the counter stays sharded.
+
+// (*) Only a release that would take the unbiased central count to zero adds the slots up. It first sweeps them into the central count
+//     and leaves them open; if that was enough, the counter carries on sharded. If the slots held nothing, the release may be the last
+//     one, and it folds the counter: it closes every slot, adds what the slots held to the central count and removes the bias. From then
+//     on every thread counts in the central count, as with AtomicCounting, and the release that takes it to zero is the last one. A
+//     thread that finds its slot closed moves on to the central count, so nothing is lost mid-fold.
+
+// (*) Sweeping and folding take turns under a flag, since a slot's count is in flight between the slot and the central count while it
+//     is swept. Every other update stays lock-free.
+
+// (*) A counter takes ShardCount + 1 cache lines, which only pays for the few bodies that every core copies at once.
+template <std::size_t ShardCount>
+class BasicShardedCounting {
+
+  static constexpr std::size_t cache_line_size = 64;
+
+  struct alignas (cache_line_size) Shard {
+
+    // The slot's count, shifted left by one, over the folded flag.
+    std::atomic<int64_t> word {0};
+  };
+
+public:
+
+  static constexpr bool thread_safe = true;
+
+  // Nobody contends on the weak count, and a sharded one would double the size of the count object.
+  using WeakCounting = AtomicCounting;
+
+  class Counter {
+
+  public:
+
+    // The counter has to start out with at least one reference, counted centrally: a reference counted in a slot may be released
+    // there without anyone adding the slots up.
+    Counter (int64_t initial_count)
+
+        : central_count (initial_count + sharded_bias)
+
+        , rebalancing (false) {
+    }
+
+    Counter (const Counter&) = delete;
+
+    Counter& operator= (const Counter&) = delete;
+
+  private:
+
+    friend class BasicShardedCounting;
+
+    Shard shards [ShardCount];
+
+    alignas (cache_line_size) std::atomic<int64_t> central_count;
+
+    // Held by whoever sweeps or folds the slots.
+    std::atomic<bool> rebalancing;
+  };
+
+  static void Increment (Counter& counter) noexcept {
+
+    int64_t word = counter.shards [LocalShard ()].word.fetch_add (count_unit, std::memory_order_relaxed);
+
+    if ((word & folded_flag) != 0) {
+
+      counter.central_count.fetch_add (1, std::memory_order_relaxed);
+    }
+  }
+
+  static bool Decrement (Counter& counter) noexcept {
+
+    std::atomic<int64_t>& slot = counter.shards [LocalShard ()].word;
+
+    int64_t word = slot.load (std::memory_order_relaxed);
+
+    while ((word & folded_flag) == 0 && (word >> 1) > 0) {
+
+      if (slot.compare_exchange_weak (word, word - count_unit, std::memory_order_release, std::memory_order_relaxed)) {
+
+        return false;
+      }
+    }
+
+    if ((word & folded_flag) != 0) {
+
+      return counter.central_count.fetch_sub (1, std::memory_order_acq_rel) == 1;
+    }
+
+    return DecrementCentral (counter);
+  }
+
+  // The bias keeps a sharded counter above one as well, so it always counts as shared.
+  static bool IsShared (const Counter& counter) noexcept {
+
+    return counter.central_count.load (std::memory_order_acquire) > 1;
+  }
+
+  // A slot that is still open belongs to a counter that hasn't been folded yet, so it can't have reached zero.
+  static bool IncrementIfNonZero (Counter& counter) noexcept {
+
+    int64_t word = counter.shards [LocalShard ()].word.fetch_add (count_unit, std::memory_order_relaxed);
+
+    if ((word & folded_flag) == 0) {
+
+      return true;
+    }
+
+    int64_t count = counter.central_count.load (std::memory_order_relaxed);
+
+    do {
+
+      if (count == 0) {
+
+        return false;
+      }
+    } while (!counter.central_count.compare_exchange_weak (count, count + 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+    return true;
+  }
+
+  // Only the central count and the calling thread's own slot: adding up every slot would pull in every other thread's cache line. While
+  // the counter is sharded, that leaves out the references counted in other slots.
+  static int64_t Sample (const Counter& counter) noexcept {
+
+    int64_t word = counter.shards [LocalShard ()].word.load (std::memory_order_relaxed);
+
+    int64_t central_count = counter.central_count.load (std::memory_order_relaxed);
+
+    if ((word & folded_flag) != 0) {
+
+      return central_count;
+    }
+
+    return central_count - sharded_bias + (word >> 1);
+  }
+
+  static void Bind (Counter&, void*, void (*) (void*)) noexcept {
+  }
+
+private:
+
+  static constexpr int64_t folded_flag = 1;
+
+  static constexpr int64_t count_unit = 2;
+
+  static constexpr int64_t sharded_bias = int64_t (1) << 40;
+
+  // Slots go to threads rather than CPUs: a thread that migrated between taking and releasing a reference would release it on another
+  // slot, and move its count to the central count for nothing.
+  static std::size_t LocalShard (void) noexcept {
+
+    static std::atomic<std::size_t> next_shard {0};
+
+    thread_local std::size_t shard = next_shard.fetch_add (1, std::memory_order_relaxed) % ShardCount;
+
+    return shard;
+  }
+
+  // Takes one reference off the central count of a counter that was sharded when the calling thread looked at its slot.
+  static bool DecrementCentral (Counter& counter) noexcept {
+
+    if (TryDecrementCentral (counter)) {
+
+      return false;
+    }
+
+    while (counter.rebalancing.exchange (true, std::memory_order_acquire)) {
+
+      std::this_thread::yield ();
+    }
+
+    bool released = Rebalance (counter);
+
+    counter.rebalancing.store (false, std::memory_order_release);
+
+    return released;
+  }
+
+  // Decrements the central count as long as that leaves its unbiased part at one or more; a folded counter's central count is far
+  // below the bias, so it never qualifies.
+  static bool TryDecrementCentral (Counter& counter) noexcept {
+
+    int64_t central_count = counter.central_count.load (std::memory_order_relaxed);
+
+    while (central_count - sharded_bias > 1) {
+
+      if (counter.central_count.compare_exchange_weak (central_count, central_count - 1, std::memory_order_release,
+                                                       std::memory_order_relaxed)) {
+
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // Runs under the rebalancing flag. The counter may have been folded, or its central count topped up, while the caller waited for it.
+  static bool Rebalance (Counter& counter) noexcept {
+
+    if ((counter.shards [0].word.load (std::memory_order_acquire) & folded_flag) != 0) {
+
+      return counter.central_count.fetch_sub (1, std::memory_order_acq_rel) == 1;
+    }
+
+    if (TryDecrementCentral (counter)) {
+
+      return false;
+    }
+
+    int64_t slot_total = 0;
+
+    for (Shard& shard : counter.shards) {
+
+      slot_total += shard.word.exchange (0, std::memory_order_acq_rel) >> 1;
+    }
+
+    counter.central_count.fetch_add (slot_total, std::memory_order_acq_rel);
+
+    if (TryDecrementCentral (counter)) {
+
+      return false;
+    }
+
+    return Fold (counter);
+  }
+
+  // Even with the slots swept, the caller's reference may be the last one. Closing the slots makes it exact: a reference taken since
+  // they were swept is either still in its slot, and added up here, or counted centrally.
+  static bool Fold (Counter& counter) noexcept {
+
+    int64_t slot_total = 0;
+
+    for (Shard& shard : counter.shards) {
+
+      slot_total += shard.word.exchange (folded_flag, std::memory_order_acq_rel) >> 1;
+    }
+
+    int64_t adjustment = slot_total - sharded_bias - 1;
+
+    return counter.central_count.fetch_add (adjustment, std::memory_order_acq_rel) + adjustment == 0;
+  }
+};
+
+// One slot per thread for up to 64 threads.
+using ShardedCounting = BasicShardedCounting<64>;
+
+#endif
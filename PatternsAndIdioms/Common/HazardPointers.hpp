@@ -0,0 +1,399 @@
+#ifndef HAZARD_POINTERS_HPP
+#define HAZARD_POINTERS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Hazard Pointers.
+
+// Hazard pointers let a thread use a body it found through a shared pointer without taking a reference to it, while other threads may
+// replace that pointer and release the body at the same time:
+
+// (*) A reader publishes the pointer it is about to use in a hazard pointer, then reads the shared pointer again. If it still points to
+//     the same body, the body can't have been retired before it was published, and it won't be reclaimed for as long as the hazard
+//     pointer keeps it.
+
+// (*) A retired body goes onto a list of the thread that retired it. Once the list holds about twice as many bodies as there are hazard
+//     pointers, the thread reads every hazard pointer and reclaims the bodies none of them protects; the others wait for the next scan.
+//     That is amortized constant time per body, and it never waits for a reader.
+
+// (*) Hazard pointers are records in a list that only ever grows (they are never freed). Every thread keeps a few of the records it
+//     released, so acquiring a hazard pointer is usually a pop off a thread-local cache rather than a search.
+
+// (*) Bodies a thread still holds when it exits, or retires while it is being torn down, are left to whichever thread scans next.
+
+
+class HazardPointerDomain {
+
+  friend class HazardPointer;
+
+public:
+
+  // The body is reclaimed once no hazard pointer protects it, on this thread or on a thread that scans later.
+  static void Retire (void* body, void (*reclaim) (void*)) {
+
+    ThreadState* thread_state = LocalState ();
+
+    if (thread_state == nullptr) {
+
+      LeaveBehind ({{body, reclaim}});
+
+      ReclaimLeftBehind ();
+
+      return;
+    }
+
+    thread_state->retired_bodies.push_back ({body, reclaim});
+
+    if (thread_state->retired_bodies.size () >= ScanThreshold ()) {
+
+      Scan (thread_state->retired_bodies);
+    }
+  }
+
+  // Reclaims every body the calling thread retired that isn't protected right now, without waiting for its list to fill up.
+  static void Reclaim (void) {
+
+    ThreadState* thread_state = LocalState ();
+
+    if (thread_state == nullptr) {
+
+      ReclaimLeftBehind ();
+
+      return;
+    }
+
+    Scan (thread_state->retired_bodies);
+  }
+
+  // True if a hazard pointer protects the body right now. A body nobody can pick up any more (it was taken out of every shared pointer)
+  // and that isn't protected stays that way.
+  static bool IsProtected (const void* body) noexcept {
+
+    for (Record* record = GetRegistry ().records.load (std::memory_order_acquire); record != nullptr; record = record->next) {
+
+      if (record->pointer.load (std::memory_order_seq_cst) == body) {
+
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+private:
+
+  struct Record {
+
+    std::atomic<const void*> pointer {nullptr};
+
+    std::atomic<bool> active {false};
+
+    Record* next = nullptr;
+  };
+
+  struct RetiredBody {
+
+    void* body;
+
+    void (*reclaim) (void*);
+  };
+
+  struct Registry {
+
+    std::atomic<Record*> records {nullptr};
+
+    std::atomic<int64_t> record_count {0};
+
+    std::mutex left_behind_lock;
+
+    std::vector<RetiredBody> left_behind_bodies;
+  };
+
+  static constexpr std::size_t cached_record_limit = 8;
+
+  static constexpr std::size_t minimum_scan_threshold = 64;
+
+  struct ThreadState {
+
+    ThreadState (void) {
+
+      // Reserved up front, so that caching a released record never allocates.
+      this->cached_records.reserve (cached_record_limit);
+    }
+
+    ~ThreadState (void) noexcept {
+
+      StateDestroyed () = true;
+
+      for (Record* cached_record : this->cached_records) {
+
+        cached_record->active.store (false, std::memory_order_release);
+      }
+
+      Scan (this->retired_bodies);
+
+      LeaveBehind (this->retired_bodies);
+    }
+
+    std::vector<Record*> cached_records;
+
+    std::vector<RetiredBody> retired_bodies;
+  };
+
+  // Never destroyed, so that bodies can still be retired while static objects are torn down at exit.
+  static Registry& GetRegistry (void) {
+
+    static Registry* registry = new Registry ();
+
+    return *registry;
+  }
+
+  // The calling thread's state, or nullptr once the thread has torn it down.
+  static ThreadState* LocalState (void) {
+
+    if (StateDestroyed ()) {
+
+      return nullptr;
+    }
+
+    thread_local ThreadState thread_state;
+
+    return &thread_state;
+  }
+
+  static bool& StateDestroyed (void) {
+
+    thread_local bool destroyed = false;
+
+    return destroyed;
+  }
+
+  static std::size_t ScanThreshold (void) {
+
+    return std::max (minimum_scan_threshold, 2 * static_cast<std::size_t> (GetRegistry ().record_count.load (std::memory_order_relaxed)));
+  }
+
+  static Record* AcquireRecord (void) {
+
+    ThreadState* thread_state = LocalState ();
+
+    if (thread_state != nullptr && !thread_state->cached_records.empty ()) {
+
+      Record* cached_record = thread_state->cached_records.back ();
+
+      thread_state->cached_records.pop_back ();
+
+      return cached_record;
+    }
+
+    Registry& registry = GetRegistry ();
+
+    for (Record* record = registry.records.load (std::memory_order_acquire); record != nullptr; record = record->next) {
+
+      if (!record->active.load (std::memory_order_relaxed) && !record->active.exchange (true, std::memory_order_acquire)) {
+
+        return record;
+      }
+    }
+
+    Record* record = new Record ();
+
+    record->active.store (true, std::memory_order_relaxed);
+
+    registry.record_count.fetch_add (1, std::memory_order_relaxed);
+
+    record->next = registry.records.load (std::memory_order_relaxed);
+
+    while (!registry.records.compare_exchange_weak (record->next, record, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+
+    return record;
+  }
+
+  static void ReleaseRecord (Record* record) noexcept {
+
+    record->pointer.store (nullptr, std::memory_order_release);
+
+    ThreadState* thread_state = LocalState ();
+
+    if (thread_state != nullptr && thread_state->cached_records.size () < cached_record_limit) {
+
+      thread_state->cached_records.push_back (record);
+
+      return;
+    }
+
+    record->active.store (false, std::memory_order_release);
+  }
+
+  static void LeaveBehind (const std::vector<RetiredBody>& retired_bodies) {
+
+    if (retired_bodies.empty ()) {
+
+      return;
+    }
+
+    Registry& registry = GetRegistry ();
+
+    std::lock_guard<std::mutex> left_behind_guard (registry.left_behind_lock);
+
+    registry.left_behind_bodies.insert (registry.left_behind_bodies.end (), retired_bodies.begin (), retired_bodies.end ());
+  }
+
+  // For threads that are being torn down and won't scan again: whatever was left behind is tried right away.
+  static void ReclaimLeftBehind (void) {
+
+    std::vector<RetiredBody> retired_bodies;
+
+    Scan (retired_bodies);
+
+    LeaveBehind (retired_bodies);
+  }
+
+  // Reclaims the bodies of the list (and those left behind by other threads) that no hazard pointer protects, and keeps the others.
+  static void Scan (std::vector<RetiredBody>& retired_bodies) {
+
+    Registry& registry = GetRegistry ();
+
+    std::vector<RetiredBody> candidate_bodies;
+
+    candidate_bodies.swap (retired_bodies);
+
+    {
+      std::lock_guard<std::mutex> left_behind_guard (registry.left_behind_lock);
+
+      candidate_bodies.insert (candidate_bodies.end (), registry.left_behind_bodies.begin (), registry.left_behind_bodies.end ());
+
+      registry.left_behind_bodies.clear ();
+    }
+
+    if (candidate_bodies.empty ()) {
+
+      return;
+    }
+
+    // Sequentially consistent, like the reader's publication and the writer's replacement of the shared pointer: a reader whose
+    // hazard pointer isn't seen here read the shared pointer after the body was taken out of it, and can't have picked it up.
+    std::vector<const void*> protected_bodies;
+
+    for (Record* record = registry.records.load (std::memory_order_acquire); record != nullptr; record = record->next) {
+
+      const void* protected_body = record->pointer.load (std::memory_order_seq_cst);
+
+      if (protected_body != nullptr) {
+
+        protected_bodies.push_back (protected_body);
+      }
+    }
+
+    std::sort (protected_bodies.begin (), protected_bodies.end ());
+
+    // Reclaiming a body may retire others onto the same list, so the kept bodies go back onto it one by one.
+    for (const RetiredBody& candidate_body : candidate_bodies) {
+
+      if (std::binary_search (protected_bodies.begin (), protected_bodies.end (), candidate_body.body)) {
+
+        retired_bodies.push_back (candidate_body);
+      }
+      else {
+
+        candidate_body.reclaim (candidate_body.body);
+      }
+    }
+  }
+};
+
+
+// Protects one body at a time from being reclaimed. Hazard pointers are meant to live on a stack for the short time a body is read.
+class HazardPointer {
+
+public:
+
+  HazardPointer (void)
+
+      : record (HazardPointerDomain::AcquireRecord ()) {
+  }
+
+  HazardPointer (const HazardPointer&) = delete;
+
+  HazardPointer& operator= (const HazardPointer&) = delete;
+
+  HazardPointer (HazardPointer&& another_hazard_pointer) noexcept
+
+      : record (another_hazard_pointer.record) {
+
+    another_hazard_pointer.record = nullptr;
+  }
+
+  HazardPointer& operator= (HazardPointer&& another_hazard_pointer) noexcept {
+
+    if (this == &another_hazard_pointer) {
+
+      return *this;
+    }
+
+    this->ReleaseRecord ();
+
+    this->record = another_hazard_pointer.record;
+
+    another_hazard_pointer.record = nullptr;
+
+    return *this;
+  }
+
+  ~HazardPointer (void) noexcept {
+
+    this->ReleaseRecord ();
+  }
+
+  // The body the source points to, protected: it is published and the source read again until both agree. Bodies taken out of the
+  // source have to be retired through HazardPointerDomain (or HazardPointerReclamation) for the protection to mean anything.
+  template <typename Body>
+  Body* Protect (const std::atomic<Body*>& source) noexcept {
+
+    Body* body = source.load (std::memory_order_relaxed);
+
+    while (true) {
+
+      this->record->pointer.store (body, std::memory_order_seq_cst);
+
+      Body* current_body = source.load (std::memory_order_seq_cst);
+
+      if (current_body == body) {
+
+        return body;
+      }
+
+      body = current_body;
+    }
+  }
+
+  // Stops protecting the body; the hazard pointer can protect another one.
+  void Reset (void) noexcept {
+
+    this->record->pointer.store (nullptr, std::memory_order_release);
+  }
+
+private:
+
+  void ReleaseRecord (void) noexcept {
+
+    if (this->record == nullptr) {
+
+      return;
+    }
+
+    HazardPointerDomain::ReleaseRecord (this->record);
+
+    this->record = nullptr;
+  }
+
+  HazardPointerDomain::Record* record;
+};
+
+#endif
@@ -0,0 +1,320 @@
+#ifndef LIFECYCLE_BENCHMARKS_HPP
+#define LIFECYCLE_BENCHMARKS_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "AllocationTracking.hpp"
+#include "OutputSink.hpp"
+
+// Lifecycle Benchmarks.
+
+// The same measurements for every idiom, so their numbers line up with each other and from one version to the next. Each idiom's
+// benchmark registers them for its own types, next to the benchmarks that are specific to it:
+
+// (*) Construction, Copying, Assignment and Destruction time one operation on every object of a batch; whatever it takes to set the
+//     operation up (or clean up after it) happens outside the timed part. Assignment copies into objects of their own, so a counted
+//     body pays for releasing the old body as well.
+
+// (*) Dispatch calls ExecuteBehaviour on every object of the batch (every run sends output to a NullOutputSink). Cloning calls Clone () on
+//     every object and deletes the clones outside the timed part.
+
+// (*) The argument is the batch size, and every batch is visited in random order. A warm batch fits in the core's private caches, a
+//     cold one is far larger than them, so nearly every object (and every body it refers to) misses. Every thread runs a batch of its
+//     own, so the multithreaded runs measure what the threads do to each other through the allocator and shared counts.
+
+// (*) Results go to the console; run the benchmark with --benchmark_out=<file> --benchmark_out_format=json to keep them (RunBenchmarks.sh
+//     does that for every idiom), and compare two runs with tools/compare.py from Google Benchmark.
+
+// (*) With allocation tracking compiled in (AllocationTracking.hpp), every run also reports the allocations and allocated bytes of one
+//     operation, counted over the timed part only. CountedAllocations and ReportAllocations do the counting for the idioms' own
+//     benchmarks as well.
+
+
+// Installs a NullOutputSink for as long as it is alive.
+class SilencedOutput {
+
+public:
+
+  SilencedOutput (void)
+
+      : previous_output_sink (SetOutputSink (this->null_output_sink)) {
+  }
+
+  ~SilencedOutput (void) noexcept {
+
+    SetOutputSink (this->previous_output_sink);
+  }
+
+private:
+
+  NullOutputSink null_output_sink;
+
+  OutputSink& previous_output_sink;
+};
+
+
+// Output is silenced once per run, before its threads start and after they stop: a sink installed and restored by every thread on its
+// own could be restored out of order.
+inline std::optional<SilencedOutput>& RunSilencedOutput (void) {
+
+  static std::optional<SilencedOutput> run_silenced_output;
+
+  return run_silenced_output;
+}
+
+inline void SilenceRunOutput (const benchmark::State&) {
+
+  RunSilencedOutput ().emplace ();
+}
+
+inline void RestoreRunOutput (const benchmark::State&) {
+
+  RunSilencedOutput ().reset ();
+}
+
+// Warm and cold batches, from 1 to 8 threads; the time is what the timed part of each iteration reports.
+inline void LifecycleRuns (benchmark::internal::Benchmark* benchmark) {
+
+  benchmark->Arg (1 << 8)->Arg (1 << 16)->ThreadRange (1, 8)->UseManualTime ()->Setup (SilenceRunOutput)->Teardown (RestoreRunOutput);
+}
+
+
+// The order a batch of the given size is visited in.
+inline std::vector<std::size_t> VisitingOrder (std::size_t batch_size) {
+
+  std::vector<std::size_t> visiting_order (batch_size);
+
+  std::iota (visiting_order.begin (), visiting_order.end (), 0);
+
+  std::shuffle (visiting_order.begin (), visiting_order.end (), std::mt19937_64 (42));
+
+  return visiting_order;
+}
+
+// Adds what the calling thread allocates for as long as it is alive to the run's allocation counters; ReportAllocations divides them up.
+// Every benchmark keeps one around its timed part.
+class CountedAllocations {
+
+public:
+
+  explicit CountedAllocations (benchmark::State& state) noexcept
+
+      : state (state)
+
+      , statistics_before (AllocationTracker::ThisThread ()) {
+  }
+
+  CountedAllocations (const CountedAllocations&) = delete;
+
+  CountedAllocations& operator= (const CountedAllocations&) = delete;
+
+  ~CountedAllocations (void) noexcept {
+
+    if constexpr (AllocationTracker::enabled) {
+
+      AllocationStatistics statistics_after = AllocationTracker::ThisThread ();
+
+      this->state.counters ["allocations"].value += statistics_after.allocations - this->statistics_before.allocations;
+
+      this->state.counters ["allocated_bytes"].value += statistics_after.allocated_bytes - this->statistics_before.allocated_bytes;
+    }
+  }
+
+private:
+
+  benchmark::State& state;
+
+  AllocationStatistics statistics_before;
+};
+
+// With allocation tracking compiled in, turns the allocation counters into allocations per operation (averaged over the threads).
+inline void ReportAllocations (benchmark::State& state, int64_t operations) {
+
+  if constexpr (AllocationTracker::enabled) {
+
+    for (const char* counter_name : {"allocations", "allocated_bytes"}) {
+
+      benchmark::Counter& counter = state.counters [counter_name];
+
+      counter = benchmark::Counter (operations > 0 ? counter.value / operations : 0.0, benchmark::Counter::kAvgThreads);
+    }
+  }
+}
+
+// Runs operation once on every object of the batch and reports the time it took as the iteration time. What the batch allocated is added
+// to the run's counters, for ReportOperations to divide up.
+template <typename Operation>
+void TimeBatch (benchmark::State& state, const std::vector<std::size_t>& visiting_order, Operation operation) {
+
+  CountedAllocations counted_allocations (state);
+
+  auto start = std::chrono::steady_clock::now ();
+
+  for (std::size_t index : visiting_order) {
+
+    operation (index);
+  }
+
+  auto stop = std::chrono::steady_clock::now ();
+
+  state.SetIterationTime (std::chrono::duration<double> (stop - start).count ());
+}
+
+// Reports the operations of every batch as the items processed, and the allocations of one operation.
+inline void ReportOperations (benchmark::State& state) {
+
+  int64_t operations = state.iterations () * state.range (0);
+
+  state.SetItemsProcessed (operations);
+
+  ReportAllocations (state, operations);
+}
+
+
+template <typename Object>
+void Construction (benchmark::State& state) {
+
+  std::vector<std::size_t> visiting_order = VisitingOrder (state.range (0));
+
+  std::vector<std::optional<Object>> objects (visiting_order.size ());
+
+  for (auto _ : state) {
+
+    TimeBatch (state, visiting_order, [&] (std::size_t index) { objects [index].emplace (); });
+
+    benchmark::ClobberMemory ();
+
+    for (auto& object : objects) {
+
+      object.reset ();
+    }
+  }
+
+  ReportOperations (state);
+}
+
+
+template <typename Object>
+void Copying (benchmark::State& state) {
+
+  std::vector<std::size_t> visiting_order = VisitingOrder (state.range (0));
+
+  std::vector<Object> sources (visiting_order.size ());
+
+  std::vector<std::optional<Object>> copies (visiting_order.size ());
+
+  for (auto _ : state) {
+
+    TimeBatch (state, visiting_order, [&] (std::size_t index) { copies [index].emplace (sources [index]); });
+
+    benchmark::ClobberMemory ();
+
+    for (auto& copy : copies) {
+
+      copy.reset ();
+    }
+  }
+
+  ReportOperations (state);
+}
+
+
+template <typename Object>
+void Assignment (benchmark::State& state) {
+
+  std::vector<std::size_t> visiting_order = VisitingOrder (state.range (0));
+
+  std::vector<Object> sources (visiting_order.size ());
+
+  std::vector<std::optional<Object>> targets (visiting_order.size ());
+
+  for (auto _ : state) {
+
+    for (auto& target : targets) {
+
+      target.emplace ();
+    }
+
+    TimeBatch (state, visiting_order, [&] (std::size_t index) { *targets [index] = sources [index]; });
+
+    benchmark::ClobberMemory ();
+  }
+
+  ReportOperations (state);
+}
+
+
+template <typename Object>
+void Destruction (benchmark::State& state) {
+
+  std::vector<std::size_t> visiting_order = VisitingOrder (state.range (0));
+
+  std::vector<std::optional<Object>> objects (visiting_order.size ());
+
+  for (auto _ : state) {
+
+    for (auto& object : objects) {
+
+      object.emplace ();
+    }
+
+    TimeBatch (state, visiting_order, [&] (std::size_t index) { objects [index].reset (); });
+
+    benchmark::ClobberMemory ();
+  }
+
+  ReportOperations (state);
+}
+
+
+template <typename Object>
+void Dispatch (benchmark::State& state) {
+
+  std::vector<std::size_t> visiting_order = VisitingOrder (state.range (0));
+
+  std::vector<Object> objects (visiting_order.size ());
+
+  for (auto _ : state) {
+
+    TimeBatch (state, visiting_order, [&] (std::size_t index) { objects [index].ExecuteBehaviour (); });
+  }
+
+  ReportOperations (state);
+}
+
+
+template <typename Object>
+void Cloning (benchmark::State& state) {
+
+  using Clone = decltype (std::declval<const Object&> ().Clone ());
+
+  std::vector<std::size_t> visiting_order = VisitingOrder (state.range (0));
+
+  std::vector<Object> prototypes (visiting_order.size ());
+
+  std::vector<Clone> clones (visiting_order.size ());
+
+  for (auto _ : state) {
+
+    TimeBatch (state, visiting_order, [&] (std::size_t index) { clones [index] = prototypes [index].Clone (); });
+
+    for (Clone clone : clones) {
+
+      delete clone;
+    }
+  }
+
+  ReportOperations (state);
+}
+
+#endif
@@ -0,0 +1,469 @@
+#ifndef OUTPUT_SINK_HPP
+#define OUTPUT_SINK_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+// Output Sink.
+
+// Every behaviour in the idioms writes through Output () instead of std::cout, and the installed sink decides where the text goes:
+
+// (*) StandardOutputSink writes straight to std::cout. This is the default, so the demos behave exactly as before.
+
+// (*) NullOutputSink formats and discards, for benchmarks that want to measure the idiom rather than the terminal.
+
+// (*) BufferedOutputSink gives every thread its own buffer. Full buffers (or flushed ones) are handed to a background thread through a
+//     lock-free multiple-producer single-consumer queue, and only that thread touches the destination stream. Writers never wait on
+//     each other or on the destination; output of one thread stays in order, output of different threads is interleaved per buffer.
+
+// (*) A buffer that never fills up is handed off anyway once it gets old. Every so often (the maximum buffer age) the background thread
+//     requests a hand-off, and each thread hands off what it buffered before that request the next time it writes. A thread that stops
+//     writing altogether keeps its last partial buffer until it flushes or exits.
+
+// A sink has to outlive every thread that writes through it.
+
+
+class OutputSink {
+
+public:
+
+  virtual ~OutputSink (void) noexcept {
+  }
+
+  // The stream the calling thread should write to.
+  virtual std::ostream& Stream (void) = 0;
+
+  // Makes everything written so far by the calling thread reach the destination.
+  virtual void Flush (void) = 0;
+};
+
+
+class StandardOutputSink : public OutputSink {
+
+public:
+
+  virtual std::ostream& Stream (void) override {
+
+    return std::cout;
+  }
+
+  virtual void Flush (void) override {
+
+    std::cout.flush ();
+  }
+};
+
+
+class NullOutputSink : public OutputSink {
+
+public:
+
+  virtual std::ostream& Stream (void) override {
+
+    thread_local DiscardingBuffer discarding_buffer;
+
+    thread_local std::ostream discarding_stream (&discarding_buffer);
+
+    return discarding_stream;
+  }
+
+  virtual void Flush (void) override {
+  }
+
+private:
+
+  // Keeps overwriting the same scratch area, so nothing written is ever kept.
+  class DiscardingBuffer : public std::streambuf {
+
+  public:
+
+    DiscardingBuffer (void) {
+
+      this->setp (this->scratch, this->scratch + sizeof (this->scratch));
+    }
+
+  protected:
+
+    virtual int_type overflow (int_type character) override {
+
+      this->setp (this->scratch, this->scratch + sizeof (this->scratch));
+
+      return traits_type::not_eof (character);
+    }
+
+  private:
+
+    char scratch [256];
+  };
+};
+
+
+class BufferedOutputSink : public OutputSink {
+
+public:
+
+  static constexpr std::size_t thread_buffer_size = 4096;
+
+  explicit BufferedOutputSink (std::ostream& destination, std::chrono::microseconds idle_interval = std::chrono::microseconds (500),
+
+                               std::chrono::microseconds maximum_buffer_age = std::chrono::microseconds (10000))
+
+      : destination (destination)
+
+      , idle_interval (idle_interval)
+
+      , maximum_buffer_age (maximum_buffer_age)
+
+      , hand_off_requests (0)
+
+      , head (&this->stub)
+
+      , tail (&this->stub)
+
+      , pending_chunks (0)
+
+      , stopping (false)
+
+      , flusher ([this] () { this->FlushLoop (); }) {
+  }
+
+  BufferedOutputSink (const BufferedOutputSink&) = delete;
+
+  BufferedOutputSink& operator= (const BufferedOutputSink&) = delete;
+
+  virtual ~BufferedOutputSink (void) noexcept override {
+
+    this->Flush ();
+
+    if (!ThreadOutput::Destroyed () && ThreadOutput::Local ().buffer.sink == this) {
+
+      ThreadOutput::Local ().buffer.sink = nullptr;
+    }
+
+    this->stopping.store (true, std::memory_order_release);
+
+    this->flusher.join ();
+  }
+
+  virtual std::ostream& Stream (void) override {
+
+    ThreadOutput& thread_output = ThreadOutput::Local ();
+
+    if (thread_output.buffer.sink != this) {
+
+      thread_output.stream.flush ();
+
+      thread_output.buffer.sink = this;
+    }
+
+    thread_output.buffer.HandOffIfRequested (this->hand_off_requests.load (std::memory_order_relaxed));
+
+    return thread_output.stream;
+  }
+
+  virtual void Flush (void) override {
+
+    if (!ThreadOutput::Destroyed () && ThreadOutput::Local ().buffer.sink == this) {
+
+      ThreadOutput::Local ().stream.flush ();
+    }
+
+    while (this->pending_chunks.load (std::memory_order_acquire) > 0) {
+
+      std::this_thread::yield ();
+    }
+  }
+
+private:
+
+  struct Chunk {
+
+    std::atomic<Chunk*> next {nullptr};
+
+    std::string text;
+  };
+
+  // The calling thread's buffer. Whatever it holds is handed to its sink when it fills up, is flushed, or the thread exits.
+  class ThreadBuffer : public std::streambuf {
+
+  public:
+
+    ThreadBuffer (void)
+
+        : sink (nullptr)
+
+        , hand_off_request (0) {
+
+      this->setp (this->storage, this->storage + thread_buffer_size);
+    }
+
+    ~ThreadBuffer (void) noexcept override {
+
+      this->HandOff ();
+    }
+
+    // Hands off what the buffer held before the sink's latest hand-off request, if anything; otherwise remembers the request, so
+    // that whatever is written from now on is handed off at the next one.
+    void HandOffIfRequested (uint64_t latest_hand_off_request) {
+
+      if (this->pptr () != this->pbase () && this->hand_off_request != latest_hand_off_request) {
+
+        this->HandOff ();
+      }
+
+      if (this->pptr () == this->pbase ()) {
+
+        this->hand_off_request = latest_hand_off_request;
+      }
+    }
+
+    BufferedOutputSink* sink;
+
+  protected:
+
+    virtual int_type overflow (int_type character) override {
+
+      this->HandOff ();
+
+      if (!traits_type::eq_int_type (character, traits_type::eof ())) {
+
+        *this->pptr () = traits_type::to_char_type (character);
+
+        this->pbump (1);
+      }
+
+      return traits_type::not_eof (character);
+    }
+
+    virtual int sync (void) override {
+
+      this->HandOff ();
+
+      return 0;
+    }
+
+  private:
+
+    void HandOff (void) {
+
+      if (this->pptr () != this->pbase () && this->sink != nullptr) {
+
+        Chunk* chunk = new Chunk ();
+
+        chunk->text.assign (this->pbase (), this->pptr ());
+
+        this->sink->Push (chunk);
+      }
+
+      this->setp (this->storage, this->storage + thread_buffer_size);
+    }
+
+    // The sink's hand-off request that was the latest when the buffer was last empty.
+    uint64_t hand_off_request;
+
+    char storage [thread_buffer_size];
+  };
+
+  struct ThreadOutput {
+
+    ThreadOutput (void)
+
+        : stream (&buffer) {
+    }
+
+    ~ThreadOutput (void) noexcept {
+
+      Destroyed () = true;
+    }
+
+    static ThreadOutput& Local (void) {
+
+      thread_local ThreadOutput thread_output;
+
+      return thread_output;
+    }
+
+    // True once the calling thread has torn down its output (a sink destroyed at exit can outlive the main thread's).
+    static bool& Destroyed (void) {
+
+      thread_local bool destroyed = false;
+
+      return destroyed;
+    }
+
+    ThreadBuffer buffer;
+
+    std::ostream stream;
+  };
+
+  // Producer side of the queue (any thread): one exchange and one store, no locks and no retries.
+  void Push (Chunk* chunk) {
+
+    this->pending_chunks.fetch_add (1, std::memory_order_relaxed);
+
+    chunk->next.store (nullptr, std::memory_order_relaxed);
+
+    Chunk* previous = this->head.exchange (chunk, std::memory_order_acq_rel);
+
+    previous->next.store (chunk, std::memory_order_release);
+  }
+
+  // Consumer side of the queue (flusher thread only). Returns nullptr if the queue is empty, or if a producer is halfway through a Push.
+  Chunk* Pop (void) {
+
+    Chunk* chunk = this->tail;
+
+    Chunk* next = chunk->next.load (std::memory_order_acquire);
+
+    if (chunk == &this->stub) {
+
+      if (next == nullptr) {
+
+        return nullptr;
+      }
+
+      this->tail = next;
+
+      chunk = next;
+
+      next = next->next.load (std::memory_order_acquire);
+    }
+
+    if (next != nullptr) {
+
+      this->tail = next;
+
+      return chunk;
+    }
+
+    if (chunk != this->head.load (std::memory_order_acquire)) {
+
+      return nullptr;
+    }
+
+    // The last chunk can only be taken once the stub is queued behind it.
+    this->Push (&this->stub);
+
+    this->pending_chunks.fetch_sub (1, std::memory_order_relaxed);
+
+    next = chunk->next.load (std::memory_order_acquire);
+
+    if (next != nullptr) {
+
+      this->tail = next;
+
+      return chunk;
+    }
+
+    return nullptr;
+  }
+
+  void FlushLoop (void) {
+
+    auto last_hand_off_request = std::chrono::steady_clock::now ();
+
+    while (true) {
+
+      // Relaxed: the writers only compare the request with the one they saw last, and answer it whenever they see it.
+      if (std::chrono::steady_clock::now () - last_hand_off_request >= this->maximum_buffer_age) {
+
+        this->hand_off_requests.fetch_add (1, std::memory_order_relaxed);
+
+        last_hand_off_request = std::chrono::steady_clock::now ();
+      }
+
+      bool stop_requested = this->stopping.load (std::memory_order_acquire);
+
+      bool wrote_any = false;
+
+      while (Chunk* chunk = this->Pop ()) {
+
+        this->destination.write (chunk->text.data (), chunk->text.size ());
+
+        delete chunk;
+
+        wrote_any = true;
+
+        this->pending_chunks.fetch_sub (1, std::memory_order_release);
+      }
+
+      if (wrote_any) {
+
+        this->destination.flush ();
+      }
+
+      if (stop_requested && this->pending_chunks.load (std::memory_order_acquire) == 0) {
+
+        return;
+      }
+
+      if (!wrote_any) {
+
+        std::this_thread::sleep_for (this->idle_interval);
+      }
+    }
+  }
+
+  std::ostream& destination;
+
+  std::chrono::microseconds idle_interval;
+
+  std::chrono::microseconds maximum_buffer_age;
+
+  // Counts the hand-offs the flusher requested so far.
+  std::atomic<uint64_t> hand_off_requests;
+
+  Chunk stub;
+
+  std::atomic<Chunk*> head;
+
+  Chunk* tail;
+
+  std::atomic<int64_t> pending_chunks;
+
+  std::atomic<bool> stopping;
+
+  std::thread flusher;
+};
+
+
+inline std::atomic<OutputSink*>& CurrentOutputSink (void) {
+
+  static StandardOutputSink standard_output_sink;
+
+  static std::atomic<OutputSink*> current_output_sink (&standard_output_sink);
+
+  return current_output_sink;
+}
+
+inline OutputSink& GetOutputSink (void) {
+
+  return *CurrentOutputSink ().load (std::memory_order_acquire);
+}
+
+// Installs a sink and returns the previous one.
+inline OutputSink& SetOutputSink (OutputSink& output_sink) {
+
+  OutputSink& previous_output_sink = GetOutputSink ();
+
+  previous_output_sink.Flush ();
+
+  CurrentOutputSink ().store (&output_sink, std::memory_order_release);
+
+  return previous_output_sink;
+}
+
+// The stream behaviours write to.
+inline std::ostream& Output (void) {
+
+  return GetOutputSink ().Stream ();
+}
+
+#endif
@@ -0,0 +1,283 @@
+#ifndef RECLAMATION_HPP
+#define RECLAMATION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "HazardPointers.hpp"
+
+// Reclamation.
+
+// Decides what happens to a body once its last reference is released. Bodies are handed over as a pointer plus the function that
+// reclaims them, so the policies don't need to know what they are reclaiming, together with a retire entry every body carries for the
+// policy's own bookkeeping. Every policy also tells whether somebody may be reading a body without holding a reference to it
+// (IsProtected), in which case its last reference must not change it in place either, and whether it may reclaim a body on another
+// thread than the one that released it (reclaims_elsewhere), in which case the body's count has to be thread-safe (Counting.hpp):
+
+// (*) ImmediateReclamation reclaims the body right away, on the thread that released it. This is the default.
+
+// (*) DeferredReclamation hands the body to a background thread and returns, so the releasing thread never pays for a destructor.
+//     Retired bodies are pushed onto a lock-free stack, linked through their retire entries so that retiring one never allocates; the
+//     background thread takes the whole stack at once and reclaims it as a batch.
+//     Only bodies whose counts are thread-safe may be retired this way, since they are reclaimed on another thread. At exit the
+//     background thread is stopped, and bodies released after that are reclaimed in place.
+
+// (*) HazardPointerReclamation holds the body back for as long as a hazard pointer (HazardPointers.hpp) protects it, which lets readers
+//     pick bodies up from a shared pointer that is replaced under them. Retired bodies are reclaimed in batches by the threads that
+//     retire them, with the same restriction on the counts as deferred reclamation.
+
+
+// Carried by every body that a reclamation policy may retire. A copy of a body is a body of its own, so the entry isn't copied with it.
+class RetireEntry {
+
+  friend class DeferredReclaimer;
+
+public:
+
+  RetireEntry (void) noexcept
+
+      : body (nullptr)
+
+      , reclaim (nullptr)
+
+      , next (nullptr) {
+  }
+
+  RetireEntry (const RetireEntry&) noexcept
+
+      : RetireEntry () {
+  }
+
+  RetireEntry& operator= (const RetireEntry&) noexcept {
+
+    return *this;
+  }
+
+private:
+
+  void* body;
+
+  void (*reclaim) (void*);
+
+  RetireEntry* next;
+};
+
+
+class ImmediateReclamation {
+
+public:
+
+  static constexpr bool reclaims_elsewhere = false;
+
+  static void Retire (RetireEntry&, void* body, void (*reclaim) (void*)) {
+
+    reclaim (body);
+  }
+
+  static bool IsProtected (const void*) noexcept {
+
+    return false;
+  }
+};
+
+
+class DeferredReclaimer {
+
+public:
+
+  explicit DeferredReclaimer (std::chrono::microseconds idle_interval = std::chrono::microseconds (1000))
+
+      : idle_interval (idle_interval)
+
+      , head (nullptr)
+
+      , pending_bodies (0)
+
+      , closed (false)
+
+      , reclaimer ([this] () { this->ReclaimLoop (); }) {
+  }
+
+  DeferredReclaimer (const DeferredReclaimer&) = delete;
+
+  DeferredReclaimer& operator= (const DeferredReclaimer&) = delete;
+
+  // Reclaims whatever is still pending before it goes.
+  ~DeferredReclaimer (void) noexcept {
+
+    this->Close ();
+  }
+
+  // Any thread: one compare-and-swap, no locks and no allocation. The entry belongs to the reclaimer until the body is reclaimed. Once
+  // the reclaimer is closed, the body is reclaimed right here instead.
+  void Retire (RetireEntry& retire_entry, void* body, void (*reclaim) (void*)) noexcept {
+
+    if (this->closed.load (std::memory_order_seq_cst)) {
+
+      reclaim (body);
+
+      return;
+    }
+
+    retire_entry.body = body;
+
+    retire_entry.reclaim = reclaim;
+
+    retire_entry.next = this->head.load (std::memory_order_relaxed);
+
+    this->pending_bodies.fetch_add (1, std::memory_order_relaxed);
+
+    while (!this->head.compare_exchange_weak (retire_entry.next, &retire_entry, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+    }
+
+    // Closed in the meantime: the background thread may have taken its last look at the stack before the push, and then nobody else
+    // will. Everything on the stack is taken and reclaimed here (the background thread takes whatever it sees, so nothing is reclaimed
+    // twice).
+    if (this->closed.load (std::memory_order_seq_cst)) {
+
+      this->ReclaimBatch (this->head.exchange (nullptr, std::memory_order_seq_cst));
+    }
+  }
+
+  // Waits until every body retired so far has been reclaimed.
+  void Drain (void) {
+
+    while (this->pending_bodies.load (std::memory_order_acquire) > 0) {
+
+      std::this_thread::yield ();
+    }
+  }
+
+  // Reclaims whatever is pending and stops the background thread; bodies retired from then on are reclaimed on the thread that retires
+  // them. Called at most once at a time.
+  void Close (void) noexcept {
+
+    this->closed.store (true, std::memory_order_seq_cst);
+
+    if (this->reclaimer.joinable ()) {
+
+      this->reclaimer.join ();
+    }
+  }
+
+private:
+
+  void ReclaimLoop (void) {
+
+    while (true) {
+
+      // Sequentially consistent, like the push and the check that follows it in Retire: a push this exchange misses after the
+      // reclaimer was closed is seen as closed by its producer, which then reclaims it.
+      bool close_requested = this->closed.load (std::memory_order_seq_cst);
+
+      // Taking the whole stack at once leaves nothing for producers to race with.
+      RetireEntry* retire_entry = this->head.exchange (nullptr, std::memory_order_seq_cst);
+
+      if (retire_entry == nullptr) {
+
+        if (close_requested) {
+
+          return;
+        }
+
+        std::this_thread::sleep_for (this->idle_interval);
+
+        continue;
+      }
+
+      this->ReclaimBatch (retire_entry);
+    }
+  }
+
+  void ReclaimBatch (RetireEntry* retire_entry) noexcept {
+
+    int64_t reclaimed_bodies = 0;
+
+    while (retire_entry != nullptr) {
+
+      // The entry goes away with its body.
+      RetireEntry* next = retire_entry->next;
+
+      retire_entry->reclaim (retire_entry->body);
+
+      retire_entry = next;
+
+      ++reclaimed_bodies;
+    }
+
+    this->pending_bodies.fetch_sub (reclaimed_bodies, std::memory_order_release);
+  }
+
+  std::chrono::microseconds idle_interval;
+
+  std::atomic<RetireEntry*> head;
+
+  std::atomic<int64_t> pending_bodies;
+
+  std::atomic<bool> closed;
+
+  std::thread reclaimer;
+};
+
+
+class DeferredReclamation {
+
+public:
+
+  static constexpr bool reclaims_elsewhere = true;
+
+  static void Retire (RetireEntry& retire_entry, void* body, void (*reclaim) (void*)) noexcept {
+
+    Shared ().Retire (retire_entry, body, reclaim);
+  }
+
+  static bool IsProtected (const void*) noexcept {
+
+    return false;
+  }
+
+  // The reclaimer every deferred body goes to, started on first use. It is never destroyed, so that bodies can still be released while
+  // static objects are torn down at exit: it is closed instead, and reclaims whatever is released after that in place.
+  static DeferredReclaimer& Shared (void) {
+
+    static DeferredReclaimer* reclaimer = new DeferredReclaimer ();
+
+    static Lifetime lifetime {*reclaimer};
+
+    return *reclaimer;
+  }
+
+private:
+
+  struct Lifetime {
+
+    ~Lifetime (void) noexcept {
+
+      this->reclaimer.Close ();
+    }
+
+    DeferredReclaimer& reclaimer;
+  };
+};
+
+
+class HazardPointerReclamation {
+
+public:
+
+  static constexpr bool reclaims_elsewhere = true;
+
+  static void Retire (RetireEntry&, void* body, void (*reclaim) (void*)) {
+
+    HazardPointerDomain::Retire (body, reclaim);
+  }
+
+  static bool IsProtected (const void* body) noexcept {
+
+    return HazardPointerDomain::IsProtected (body);
+  }
+};
+
+#endif
@@ -1,141 +1,160 @@
-#include <iostream>
 #include <string>
+#include <thread>
+#include <utility>
 
-// Counted Body Idiom.
+#include "CountedBody.hpp"
+#include "CountedHandle.hpp"
+#include "RepresentationSlot.hpp"
 
-// Motivation:
 
-// (1) Naive object assignment is quite expensive. Reasoning to this statement is that the compiler's default assignment constructor performs a 
-//     recursive member-wise copy (shallow copy). This works fairly well if your members are small, non-reference types such as char, double, etc.
-//     However, imagine if your members are larger, more complex types like a matrix concrete data type decorated with all the fancy data structures
-//     the STL provides. This can even be worse if the member is a reference type which can cause unwanted memory access if you're not careful.
+int main (int arg_count, char* arg_vector []) {
 
-// (2) The above can be avoided if we indeed use pointers. Say pointer1 points to the same object as pointer 2. Fairly efficient as both doesn't
-//     hold the same yet distinct copies their underlying object. However, this can be messy to manage for the client; this is not easy to use.
+  // Demo of the Counted Body Idiom.
 
-// Solution:
+  // Empty constructor:
+  Representation first_representation_object;
 
-// (*) Maintain an object structure as defined in the HandleBody.cpp idiom.
+  first_representation_object.ExecuteBehaviour ();
 
-// (*) Add a reference counter to the implementation class.
+  // Using copy constructor:
+  Representation second_representation_object (first_representation_object);
 
-// (*) Whenever a copy is done in the representation, the pointer to the same implementation class is copied to the desired representation.
+  second_representation_object.ExecuteBehaviour ();
 
-// (*) Let the representation class manage the implementation memory. Simply decrement the reference count if a representation is deleted and 
-//     increment if an assignment occurs. If the reference count to the implementation class is 0 by the end of a reference count decrement,
-//     then that signals that the implementation is no longer needed and will have to be deallocated from the heap.
+  // Using assignment operator:
+  Representation third_representation_object;
 
-// Structure:
+  third_representation_object = second_representation_object;
 
+  third_representation_object.ExecuteBehaviour ();
 
-class Implementation {
+  // Using move constructor (same implementation, no count update):
+  Representation fourth_representation_object (std::move (third_representation_object));
 
-  friend class Representation;
+  fourth_representation_object.ExecuteBehaviour ();
 
-private:
-  
-  Implementation (void)
+  // Using copy-on-write (the copy shares the body until it is changed, then detaches onto one of its own):
+  Representation fifth_representation_object (fourth_representation_object);
 
-      : reference_count (0) {
-  }
+  fifth_representation_object.ExecuteBehaviour ();
 
-  ~Implementation (void) noexcept {
-  }
+  fifth_representation_object.SetMessage ("Behaviour is executed from a detached copy of the Implementation class");
 
-  void Behaviour (void) const {
-  
-    std::cout << "Behaviour is executed from the Implementation class through the Representaiton class\n";
-  }
+  fifth_representation_object.ExecuteBehaviour ();
 
-  int64_t reference_count;
-};
+  fourth_representation_object.ExecuteBehaviour ();
 
+  // Using a weak representation (it can only be locked while some representation still holds the body):
+  Representation sixth_representation_object;
 
-class Representation {
+  WeakRepresentation weak_representation_object (sixth_representation_object);
 
-public:
-  Representation (void)
-   
-      : implementation (new Implementation ()) {
+  if (Representation locked_representation_object = weak_representation_object.Lock ()) {
 
-    this->IncrementReferenceCount ();
+    locked_representation_object.ExecuteBehaviour ();
   }
 
-  Representation (const Representation& another_representation) {
-    
-    this->implementation = another_representation.implementation;
+  sixth_representation_object = fifth_representation_object;
 
-    this->IncrementReferenceCount ();
-  }
+  if (!weak_representation_object.Lock ()) {
 
-  ~Representation (void) noexcept {
-  
-    this->DecrementReferenceCount ();
+    Output () << "The weak representation can't be locked once its body is gone.\n";
   }
 
-  void operator= (const Representation& another_representation) {
-  
-    this->DecrementReferenceCount ();
+  // Using assignment between representations that already share a body (the sole representation of a body assigned to itself
+  // included): no count is touched. Assignments return the representation they assigned to, so they chain:
+  Representation seventh_representation_object;
 
-    this->implementation = another_representation.implementation;
+  Representation& same_representation_object = seventh_representation_object;
 
-    this->IncrementReferenceCount ();
-  }
+  seventh_representation_object = same_representation_object;
 
-  void ExecuteBehaviour (void) const {
-    
-    this->implementation->Behaviour ();
-    
-    std::cout << "\tRepresentation address: " << this << " || Implementation address: " << this->implementation << '\n';
-  }
+  Representation eighth_representation_object;
 
+  Representation ninth_representation_object;
 
-private:
+  ninth_representation_object = eighth_representation_object = seventh_representation_object;
 
-  void DecrementReferenceCount (void) {
-    
-    --this->implementation->reference_count;
+  ninth_representation_object.ExecuteBehaviour ();
 
-    if (this->implementation->reference_count > 0) {
-      
-      return;
-    }
+  // Using biased counting (this thread created the body, so copies made here never touch an atomic count):
+  BiasedRepresentation biased_representation_object;
 
-    delete this->implementation;
+  BiasedRepresentation copied_biased_representation_object (biased_representation_object);
 
-    this->implementation == nullptr;
-  }
+  copied_biased_representation_object.ExecuteBehaviour ();
 
-  void IncrementReferenceCount (void) {
-    
-    ++this->implementation->reference_count;
-  }
+  // Using deferred reclamation (the body is destroyed by a background thread once the last representation is gone):
+  DeferredRepresentation deferred_representation_object;
 
-  Implementation* implementation;
-};
+  deferred_representation_object.ExecuteBehaviour ();
 
+  // Using a counted handle (any type can be the body; here two handles share a std::string until one of them changes it):
+  CountedHandle<std::string> first_counted_handle = CountedHandle<std::string>::Create ("A counted std::string");
 
+  CountedHandle<std::string> second_counted_handle (first_counted_handle);
 
-int main (int arg_count, char* arg_vector []) {
-  
-  // Demo of the Counted Body Idiom.
+  second_counted_handle.Mutate () += ", detached on write";
 
-  // Empty constructor:
-  Representation first_representation_object;
+  Output () << *first_counted_handle << " || " << *second_counted_handle << '\n';
 
-  first_representation_object.ExecuteBehaviour ();
+  // Using the atomic counting policy to share a body with another thread (both threads write through a buffered sink, so neither
+  // waits on std::cout):
+  BufferedOutputSink buffered_output_sink (std::cout);
 
-  // Using copy constructor:
-  Representation second_representation_object (first_representation_object);
+  OutputSink& standard_output_sink = SetOutputSink (buffered_output_sink);
 
-  second_representation_object.ExecuteBehaviour ();
+  AtomicRepresentation shared_representation_object;
 
-  // Using assignment operator:
-  Representation third_representation_object;
+  std::thread worker ([shared_representation_object] () {
 
-  third_representation_object = second_representation_object;
+    AtomicRepresentation worker_representation_object (shared_representation_object);
+
+    worker_representation_object = shared_representation_object;
+
+    worker_representation_object.ExecuteBehaviour ();
+  });
+
+  worker.join ();
+
+  shared_representation_object.ExecuteBehaviour ();
+
+  // Using a representation slot to publish a body to another thread while replacing it (neither thread takes a lock; the reader sees
+  // whichever body the slot holds when it loads):
+  RepresentationSlot representation_slot {HazardRepresentation ()};
+
+  std::thread reader ([&representation_slot] () {
+
+    HazardRepresentation loaded_representation_object = representation_slot.Load ();
+
+    loaded_representation_object.ExecuteBehaviour ();
+  });
+
+  HazardRepresentation stored_representation_object;
+
+  stored_representation_object.SetMessage ("Behaviour is executed from the Implementation class stored into the slot");
+
+  representation_slot.Store (stored_representation_object);
+
+  // A compare-and-exchange only replaces the body it expects:
+  HazardRepresentation expected_representation_object (stored_representation_object);
+
+  if (representation_slot.CompareExchange (expected_representation_object, HazardRepresentation ())) {
+
+    expected_representation_object.ExecuteBehaviour ();
+  }
+
+  reader.join ();
+
+  representation_slot.Load ().ExecuteBehaviour ();
+
+  // Borrowing from the slot (the body is read under a hazard pointer, and its count is never touched):
+  if (BorrowedRepresentation borrowed_representation_object = representation_slot.Borrow ()) {
+
+    borrowed_representation_object.ExecuteBehaviour ();
+  }
+
+  SetOutputSink (standard_output_sink);
 
-  third_representation_object.ExecuteBehaviour ();
-  
   return 0;
 }
@@ -0,0 +1,522 @@
+#ifndef COUNTED_BODY_HPP
+#define COUNTED_BODY_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "../Common/AllocationTracking.hpp"
+#include "../Common/CountTracking.hpp"
+#include "../Common/Counting.hpp"
+#include "../Common/OutputSink.hpp"
+#include "../Common/Reclamation.hpp"
+
+// Counted Body Idiom.
+
+// Motivation:
+
+// (1) Naive object assignment is quite expensive. Reasoning to this statement is that the compiler's default assignment constructor performs a
+//     recursive member-wise copy (shallow copy). This works fairly well if your members are small, non-reference types such as char, double, etc.
+//     However, imagine if your members are larger, more complex types like a matrix concrete data type decorated with all the fancy data structures
+//     the STL provides. This can even be worse if the member is a reference type which can cause unwanted memory access if you're not careful.
+
+// (2) The above can be avoided if we indeed use pointers. Say pointer1 points to the same object as pointer 2. Fairly efficient as both doesn't
+//     hold the same yet distinct copies their underlying object. However, this can be messy to manage for the client; this is not easy to use.
+
+// Solution:
+
+// (*) Maintain an object structure as defined in the HandleBody.cpp idiom.
+
+// (*) Add a reference counter to the implementation class.
+
+// (*) Whenever a copy is done in the representation, the pointer to the same implementation class is copied to the desired representation.
+
+// (*) Let the representation class manage the implementation memory. Simply decrement the reference count if a representation is deleted and
+//     increment if an assignment occurs. If the reference count to the implementation class is 0 by the end of a reference count decrement,
+//     then that signals that the implementation is no longer needed and will have to be deallocated from the heap.
+
+// (*) Leave the way the count is updated to a counting policy. A plain integer is the cheapest but only works if every copy of a body lives
+//     on one thread. Once representations are passed between threads, the count has to be atomic: increments can be relaxed since a new
+//     reference is always made from one that is already alive, while the decrement that hits zero has to see every other thread's use of
+//     the body before it deletes it (release on each decrement, acquire on the last one). The policies live in Counting.hpp.
+
+// (*) Most representations are copied and destroyed on the thread that created their body, and an atomic count makes every one of
+//     those copies pay for a read-modify-write anyway. With biased counting the creating thread owns the body and counts in a plain
+//     integer, every other thread counts in a shared atomic count, and the two are merged once the owner lets go of its references.
+
+// (*) A representation that is about to die doesn't need to share its body, it can hand it over. Moving a representation steals the
+//     pointer and leaves the source empty, so returning by value or relocating representations inside a container costs no count updates.
+
+// (*) Assigning a representation that already shares the body does nothing at all, so neither count traffic nor a self-assignment can
+//     release the body on the way. Any other assignment takes its new reference before it lets go of the old one.
+
+// (*) Sharing a body is only safe as long as nobody changes it. Instead of every caller deep-copying up front just in case, changes go
+//     through the representation, which copies the body on write: a non-const operation first checks the count and, if the body is
+//     still shared with another representation, detaches onto a private copy of its own. Representations that are only ever read keep
+//     sharing one body, however many copies of them are made.
+
+// (*) A cache that holds representations keeps every body in it alive forever. A weak representation watches a body without owning it:
+//     the body carries a second, weak count next to the strong one, and Lock turns a weak representation back into a representation
+//     only while the strong count is above zero (a compare-and-swap on the atomic policy, never a lock). When the last representation
+//     goes, the body gives up its state at once but keeps its counts until the last weak representation goes as well.
+
+// (*) Whoever releases the last representation also pays for destroying the body, however long that takes. A reclamation policy
+//     (Reclamation.hpp) can take that off the releasing thread: with deferred reclamation the body is handed to a background thread
+//     that reclaims retired bodies in batches, and the release itself costs one push onto a lock-free stack.
+
+// (*) A representation that threads share through one variable (a current configuration, say) would need a lock around every copy
+//     and assignment of it. A representation slot (RepresentationSlot.hpp) holds it instead: readers load a representation out of it
+//     and writers store, exchange or compare-and-exchange a new one, none of them ever taking a lock. A reader that only looks at the
+//     body for a moment borrows it from the slot instead, under a hazard pointer and without touching its count at all.
+
+// (*) Everything above is written against one Implementation class. CountedHandle.hpp applies the idiom to any type, with the counting
+//     and reclamation policies as template parameters.
+
+// Structure:
+
+
+template <typename CountingPolicy>
+class BasicRepresentationSlot;
+
+template <typename CountingPolicy>
+class BasicBorrowedRepresentation;
+
+
+template <typename CountingPolicy>
+class BasicImplementation : public TrackedCount {
+
+  template <typename, typename> friend class BasicRepresentation;
+
+  template <typename, typename> friend class BasicWeakRepresentation;
+
+  template <typename> friend class BasicRepresentationSlot;
+
+  template <typename> friend class BasicBorrowedRepresentation;
+
+private:
+
+  BasicImplementation (void)
+
+      : message ("Behaviour is executed from the Implementation class through the Representaiton class")
+
+      , reference_count (0)
+
+      , weak_reference_count (1) {
+  }
+
+  // Detaching copies the state, not the references: the copy starts out unreferenced.
+  BasicImplementation (const BasicImplementation& another_implementation)
+
+      : TrackedCount ()
+
+      , message (another_implementation.message)
+
+      , reference_count (0)
+
+      , weak_reference_count (1) {
+  }
+
+  ~BasicImplementation (void) noexcept {
+  }
+
+  void Behaviour (void) const {
+
+    Output () << this->message << '\n';
+  }
+
+  // Called once the last representation is gone; only the counts have to survive for the weak representations.
+  void ReleaseState (void) noexcept {
+
+    std::string ().swap (this->message);
+  }
+
+  // Static rather than a member that deletes its own object, and freeing out of line: with the free inlined, GCC follows paths where
+  // two bodies are the same one, which the counts rule out, and warns about a count updated after the body was freed (-Wuse-after-free).
+  static void ReleaseWeakReference (BasicImplementation* implementation) noexcept {
+
+    if (!CountingPolicy::WeakCounting::Decrement (implementation->weak_reference_count)) {
+      return;
+    }
+
+    Destroy (implementation);
+  }
+
+  __attribute__ ((noinline)) static void Destroy (void* implementation) noexcept {
+
+    CLEANCODE_COUNT_FREE ("CountedBody", "BasicImplementation::Destroy", sizeof (BasicImplementation));
+
+    delete static_cast<BasicImplementation*> (implementation);
+  }
+
+  std::string message;
+
+  typename CountingPolicy::Counter reference_count;
+
+  // Weak representations, plus one on behalf of all the representations for as long as there are any.
+  typename CountingPolicy::WeakCounting::Counter weak_reference_count;
+
+  RetireEntry retire_entry;
+};
+
+
+template <typename CountingPolicy, typename ReclamationPolicy = ImmediateReclamation>
+class BasicRepresentation {
+
+  static_assert (CountingPolicy::thread_safe || !ReclamationPolicy::reclaims_elsewhere,
+                 "A body reclaimed on another thread needs a thread-safe counting policy.");
+
+  template <typename, typename> friend class BasicWeakRepresentation;
+
+  template <typename> friend class BasicRepresentationSlot;
+
+  template <typename> friend class BasicBorrowedRepresentation;
+
+public:
+
+  BasicRepresentation (void)
+
+      : implementation (new BasicImplementation<CountingPolicy> ()) {
+
+    CLEANCODE_COUNT_ALLOCATION ("CountedBody", "BasicRepresentation ()", sizeof (BasicImplementation<CountingPolicy>));
+
+    this->BindImplementation ();
+
+    this->IncrementReferenceCount ();
+  }
+
+  BasicRepresentation (const BasicRepresentation& another_representation) {
+
+    this->implementation = another_representation.implementation;
+
+    CLEANCODE_COUNT_EVENT ("CountedBody", copy);
+
+    this->IncrementReferenceCount ();
+  }
+
+  // Moving hands the body over without touching the count; the moved-from representation is left empty.
+  BasicRepresentation (BasicRepresentation&& another_representation) noexcept
+
+      : implementation (another_representation.implementation) {
+
+    CLEANCODE_COUNT_EVENT ("CountedBody", move);
+
+    another_representation.implementation = nullptr;
+  }
+
+  ~BasicRepresentation (void) noexcept {
+
+    this->DecrementReferenceCount ();
+  }
+
+  // Assigning a representation that already shares the body (itself included) touches no count at all. Otherwise the new body is
+  // referenced and the representation switched over to it before the old body is let go, so releasing the old body can never reclaim
+  // the one being assigned, and nothing that can fail runs before the representation has changed.
+  BasicRepresentation& operator= (const BasicRepresentation& another_representation) {
+
+    CLEANCODE_COUNT_ASSIGNMENT ("CountedBody", this->implementation == another_representation.implementation);
+
+    if (this->implementation == another_representation.implementation) {
+
+      return *this;
+    }
+
+    another_representation.IncrementReferenceCount ();
+
+    BasicImplementation<CountingPolicy>* previous_implementation = this->implementation;
+
+    this->implementation = another_representation.implementation;
+
+    ReleaseReference (previous_implementation);
+
+    return *this;
+  }
+
+  BasicRepresentation& operator= (BasicRepresentation&& another_representation) noexcept {
+
+    CLEANCODE_COUNT_EVENT ("CountedBody", move_assignment);
+
+    if (this == &another_representation) {
+
+      return *this;
+    }
+
+    BasicImplementation<CountingPolicy>* previous_implementation = this->implementation;
+
+    this->implementation = another_representation.implementation;
+
+    another_representation.implementation = nullptr;
+
+    ReleaseReference (previous_implementation);
+
+    return *this;
+  }
+
+  // False for a moved-from representation, or one handed out by a weak representation whose body was already gone.
+  explicit operator bool (void) const noexcept {
+
+    return this->implementation != nullptr;
+  }
+
+  void ExecuteBehaviour (void) const {
+
+    this->implementation->Behaviour ();
+
+    Output () << "\tRepresentation address: " << this << " || Implementation address: " << this->implementation << '\n';
+  }
+
+  // How many representations share the body, as this thread sees it (see Sample in Counting.hpp); 0 for an empty representation.
+  int64_t UseCount (void) const noexcept {
+
+    if (this->implementation == nullptr) {
+
+      return 0;
+    }
+
+    return CountingPolicy::Sample (this->implementation->reference_count);
+  }
+
+  const std::string& GetMessage (void) const {
+
+    return this->implementation->message;
+  }
+
+  // Non-const: the body is detached first if other representations still share it.
+  void SetMessage (const std::string& new_message) {
+
+    this->Detach ();
+
+    this->implementation->message = new_message;
+  }
+
+private:
+
+  // Adopts a body whose count was already incremented on this representation's behalf.
+  explicit BasicRepresentation (BasicImplementation<CountingPolicy>* implementation) noexcept
+
+      : implementation (implementation) {
+  }
+
+  // Gives this representation a body of its own if it currently shares one, with another representation or with a weak one that could
+  // lock it at any moment, or if a borrowed representation may still be reading it. The copy is made before the shared body is let go,
+  // so a copy that throws leaves the representation as it was.
+  void Detach (void) {
+
+    if (!CountingPolicy::IsShared (this->implementation->reference_count)
+        && !CountingPolicy::WeakCounting::IsShared (this->implementation->weak_reference_count)
+        && !ReclamationPolicy::IsProtected (this->implementation)) {
+
+      return;
+    }
+
+    BasicImplementation<CountingPolicy>* detached_implementation = new BasicImplementation<CountingPolicy> (*this->implementation);
+
+    CLEANCODE_COUNT_ALLOCATION ("CountedBody", "BasicRepresentation::Detach", sizeof (BasicImplementation<CountingPolicy>));
+
+    this->DecrementReferenceCount ();
+
+    this->implementation = detached_implementation;
+
+    this->BindImplementation ();
+
+    this->IncrementReferenceCount ();
+  }
+
+  // Tells both counts of a new body how it is reclaimed, for counting policies that may find out about the last release late.
+  void BindImplementation (void) noexcept {
+
+    CountingPolicy::Bind (this->implementation->reference_count, this->implementation, &BasicRepresentation::RetireImplementation);
+
+    CountingPolicy::WeakCounting::Bind (this->implementation->weak_reference_count, this->implementation, &BasicImplementation<CountingPolicy>::Destroy);
+  }
+
+  void DecrementReferenceCount (void) {
+
+    ReleaseReference (this->implementation);
+
+    this->implementation = nullptr;
+  }
+
+  // Lets go of one reference to the body, retiring it if that was the last one.
+  static void ReleaseReference (BasicImplementation<CountingPolicy>* implementation) {
+
+    if (implementation == nullptr) {
+
+      return;
+    }
+
+    CLEANCODE_COUNT_DECREMENT ("CountedBody");
+
+    if (!CountingPolicy::Decrement (implementation->reference_count)) {
+
+      return;
+    }
+
+    RetireImplementation (implementation);
+  }
+
+  static void RetireImplementation (void* implementation) {
+
+    CLEANCODE_COUNT_RELEASE ("CountedBody", *static_cast<BasicImplementation<CountingPolicy>*> (implementation));
+
+    ReclamationPolicy::Retire (static_cast<BasicImplementation<CountingPolicy>*> (implementation)->retire_entry, implementation,
+                               &BasicRepresentation::ReclaimImplementation);
+  }
+
+  // Runs once the last representation is gone, on whichever thread the reclamation policy picks.
+  static void ReclaimImplementation (void* implementation) {
+
+    BasicImplementation<CountingPolicy>* released_implementation = static_cast<BasicImplementation<CountingPolicy>*> (implementation);
+
+    released_implementation->ReleaseState ();
+
+    BasicImplementation<CountingPolicy>::ReleaseWeakReference (released_implementation);
+  }
+
+  void IncrementReferenceCount (void) const noexcept {
+
+    if (this->implementation == nullptr) {
+
+      return;
+    }
+
+    CountingPolicy::Increment (this->implementation->reference_count);
+
+    CLEANCODE_COUNT_INCREMENT ("CountedBody", *this->implementation, CountingPolicy::Sample (this->implementation->reference_count));
+  }
+
+  BasicImplementation<CountingPolicy>* implementation;
+};
+
+
+// Watches the body of a representation without keeping it alive.
+template <typename CountingPolicy, typename ReclamationPolicy = ImmediateReclamation>
+class BasicWeakRepresentation {
+
+public:
+
+  BasicWeakRepresentation (const BasicRepresentation<CountingPolicy, ReclamationPolicy>& representation)
+
+      : implementation (representation.implementation) {
+
+    this->IncrementWeakReferenceCount ();
+  }
+
+  BasicWeakRepresentation (const BasicWeakRepresentation& another_weak_representation)
+
+      : implementation (another_weak_representation.implementation) {
+
+    this->IncrementWeakReferenceCount ();
+  }
+
+  BasicWeakRepresentation (BasicWeakRepresentation&& another_weak_representation) noexcept
+
+      : implementation (another_weak_representation.implementation) {
+
+    another_weak_representation.implementation = nullptr;
+  }
+
+  ~BasicWeakRepresentation (void) noexcept {
+
+    this->DecrementWeakReferenceCount ();
+  }
+
+  // The new body is referenced before the old one is released, which also keeps self-assignment safe.
+  BasicWeakRepresentation& operator= (const BasicWeakRepresentation& another_weak_representation) {
+
+    BasicImplementation<CountingPolicy>* previous_implementation = this->implementation;
+
+    this->implementation = another_weak_representation.implementation;
+
+    this->IncrementWeakReferenceCount ();
+
+    if (previous_implementation != nullptr) {
+
+      BasicImplementation<CountingPolicy>::ReleaseWeakReference (previous_implementation);
+    }
+
+    return *this;
+  }
+
+  BasicWeakRepresentation& operator= (BasicWeakRepresentation&& another_weak_representation) noexcept {
+
+    if (this == &another_weak_representation) {
+
+      return *this;
+    }
+
+    this->DecrementWeakReferenceCount ();
+
+    this->implementation = another_weak_representation.implementation;
+
+    another_weak_representation.implementation = nullptr;
+
+    return *this;
+  }
+
+  // A representation of the body if it is still alive, an empty one otherwise.
+  BasicRepresentation<CountingPolicy, ReclamationPolicy> Lock (void) const {
+
+    if (this->implementation == nullptr || !CountingPolicy::IncrementIfNonZero (this->implementation->reference_count)) {
+
+      return BasicRepresentation<CountingPolicy, ReclamationPolicy> (nullptr);
+    }
+
+    CLEANCODE_COUNT_INCREMENT ("CountedBody", *this->implementation, CountingPolicy::Sample (this->implementation->reference_count));
+
+    return BasicRepresentation<CountingPolicy, ReclamationPolicy> (this->implementation);
+  }
+
+private:
+
+  void DecrementWeakReferenceCount (void) noexcept {
+
+    if (this->implementation == nullptr) {
+
+      return;
+    }
+
+    BasicImplementation<CountingPolicy>::ReleaseWeakReference (this->implementation);
+
+    this->implementation = nullptr;
+  }
+
+  void IncrementWeakReferenceCount (void) noexcept {
+
+    if (this->implementation == nullptr) {
+
+      return;
+    }
+
+    CountingPolicy::WeakCounting::Increment (this->implementation->weak_reference_count);
+  }
+
+  BasicImplementation<CountingPolicy>* implementation;
+};
+
+
+// Representations whose copies all stay on one thread.
+using Representation = BasicRepresentation<SingleThreadedCounting>;
+
+// Representations that can be copied and destroyed from any thread.
+using AtomicRepresentation = BasicRepresentation<AtomicCounting>;
+
+// Representations that are cheapest to copy and destroy on the thread that created their body, but can be used from any thread.
+using BiasedRepresentation = BasicRepresentation<BiasedCounting>;
+
+// Representations that can be copied and destroyed from any thread, and never destroy a body on the thread that releases it.
+using DeferredRepresentation = BasicRepresentation<AtomicCounting, DeferredReclamation>;
+
+// Representations that can be copied and destroyed from any thread, and whose bodies outlive every hazard pointer protecting them: the
+// ones a representation slot holds.
+using HazardRepresentation = BasicRepresentation<AtomicCounting, HazardPointerReclamation>;
+
+using WeakRepresentation = BasicWeakRepresentation<SingleThreadedCounting>;
+
+using AtomicWeakRepresentation = BasicWeakRepresentation<AtomicCounting>;
+
+using BiasedWeakRepresentation = BasicWeakRepresentation<BiasedCounting>;
+
+using DeferredWeakRepresentation = BasicWeakRepresentation<AtomicCounting, DeferredReclamation>;
+
+using HazardWeakRepresentation = BasicWeakRepresentation<AtomicCounting, HazardPointerReclamation>;
+
+#endif
@@ -0,0 +1,641 @@
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "CountedBody.hpp"
+#include "RepresentationSlot.hpp"
+#include "../Common/LifecycleBenchmarks.hpp"
+
+// Counted Body Idiom Benchmarks.
+
+// Build: g++ -std=c++17 -O2 CountedBodyBenchmark.cpp -lbenchmark -lpthread
+
+// Copy/destroy stress: every iteration copies one shared handle and lets the copy go, so each iteration is exactly one increment and
+// one decrement on the same reference count.
+
+// (*) Representation is the single-threaded count; it can only be measured from one thread.
+
+// (*) The locked variant is how a single-threaded count has to be shared today: every copy and destruction under one global lock.
+
+// (*) AtomicRepresentation is the atomic counting policy, copied from every thread at once.
+
+// Owner-dominated against shared copies, atomic against biased counting:
+
+// (*) Owner-dominated: every thread copies and destroys handles of a body it created itself, so with biased counting no count update
+//     is atomic.
+
+// (*) Shared: every thread copies and destroys handles of one body, created by whichever thread got there first; with biased counting
+//     only that thread's copies stay off the shared count.
+
+// Same-body assignment: every thread keeps a copy of one shared handle and assigns the shared handle to it over and over. Both already
+// share the body, so the assignment has nothing to do; each iteration measures what it costs anyway.
+
+// Published representation: one writer thread keeps storing a new body into a shared slot while every other thread loads the current
+// one and reads it. The locked slot is how that is done without the representation slot, a lock around every copy and assignment of
+// one shared representation. The counters report loads and stores per second across all threads.
+
+// Read contention: every thread reads one shared body over and over, up to 32 threads at once. Copying a shared handle and loading from
+// a slot both take a reference for each read (an increment and a decrement on the one count every thread writes to); borrowing from a
+// slot only publishes the body in the reading thread's own hazard pointer.
+
+// Vector push: copies of one handle are pushed into a growing vector, once with the move operations and once through a copy-only wrapper
+// (how the representation behaved before it had them). The counters report count updates per pushed handle; one increment per push is
+// unavoidable, everything above it is the vector relocating its elements.
+
+// Read-heavy trace: every step hands a caller its own copy of a shared handle, which the caller then reads or, once in a while, changes.
+// Eager copying makes a new body at every hand-out in case the caller writes; copy-on-write hands out the shared body and only detaches
+// on the write. The argument is the number of writes per thousand steps, and the counters report bodies created per step and the
+// share of hand-outs that never needed a body of their own.
+
+// Release latency: every iteration times the release of the last representation of a body, one body in 64 holding a large message
+// (the argument, in bytes) whose memory goes back to the system when it is destroyed. Immediate reclamation destroys the body in the release, deferred
+// reclamation hands it to the background thread. The counters are percentiles of the release latency, in nanoseconds.
+
+// Lifecycle: construction, copying, assignment, destruction and dispatch with each counting policy, on warm and cold batches from 1 to
+// 8 threads (see LifecycleBenchmarks.hpp). Every object has a body of its own, so the threads only meet in the allocator.
+
+
+static void BM_CopyDestroy_SingleThreaded (benchmark::State& state) {
+
+  Representation shared_representation_object;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      Representation copied_representation_object (shared_representation_object);
+
+      benchmark::DoNotOptimize (copied_representation_object);
+    }
+  }
+
+  ReportAllocations (state, state.iterations ());
+}
+
+BENCHMARK (BM_CopyDestroy_SingleThreaded);
+
+
+static void BM_CopyDestroy_Locked (benchmark::State& state) {
+
+  static std::mutex representation_lock;
+
+  static Representation shared_representation_object;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      std::lock_guard<std::mutex> copy_guard (representation_lock);
+
+      Representation copied_representation_object (shared_representation_object);
+
+      benchmark::DoNotOptimize (copied_representation_object);
+    }
+  }
+
+  ReportAllocations (state, state.iterations ());
+}
+
+BENCHMARK (BM_CopyDestroy_Locked)->ThreadRange (1, 8)->UseRealTime ();
+
+
+static void BM_CopyDestroy_Atomic (benchmark::State& state) {
+
+  static AtomicRepresentation shared_representation_object;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      AtomicRepresentation copied_representation_object (shared_representation_object);
+
+      benchmark::DoNotOptimize (copied_representation_object);
+    }
+  }
+
+  ReportAllocations (state, state.iterations ());
+}
+
+BENCHMARK (BM_CopyDestroy_Atomic)->ThreadRange (1, 8)->UseRealTime ();
+
+
+template <typename Handle>
+static void OwnerDominated (benchmark::State& state) {
+
+  Handle owned_representation_object;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      Handle copied_representation_object (owned_representation_object);
+
+      benchmark::DoNotOptimize (copied_representation_object);
+    }
+  }
+
+  ReportAllocations (state, state.iterations ());
+}
+
+BENCHMARK_TEMPLATE (OwnerDominated, AtomicRepresentation)->ThreadRange (1, 8)->UseRealTime ();
+
+BENCHMARK_TEMPLATE (OwnerDominated, BiasedRepresentation)->ThreadRange (1, 8)->UseRealTime ();
+
+
+template <typename Handle>
+static void Shared (benchmark::State& state) {
+
+  static Handle shared_representation_object;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      Handle copied_representation_object (shared_representation_object);
+
+      benchmark::DoNotOptimize (copied_representation_object);
+    }
+  }
+
+  ReportAllocations (state, state.iterations ());
+}
+
+BENCHMARK_TEMPLATE (Shared, AtomicRepresentation)->ThreadRange (1, 8)->UseRealTime ();
+
+BENCHMARK_TEMPLATE (Shared, BiasedRepresentation)->ThreadRange (1, 8)->UseRealTime ();
+
+
+template <typename Handle>
+static void SameBodyAssignment (benchmark::State& state) {
+
+  static Handle shared_representation_object;
+
+  Handle assigned_representation_object (shared_representation_object);
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      assigned_representation_object = shared_representation_object;
+
+      benchmark::DoNotOptimize (assigned_representation_object);
+    }
+  }
+
+  ReportAllocations (state, state.iterations ());
+}
+
+BENCHMARK_TEMPLATE (SameBodyAssignment, Representation);
+
+BENCHMARK_TEMPLATE (SameBodyAssignment, AtomicRepresentation)->ThreadRange (1, 8)->UseRealTime ();
+
+BENCHMARK_TEMPLATE (SameBodyAssignment, BiasedRepresentation)->ThreadRange (1, 8)->UseRealTime ();
+
+
+class LockedRepresentationSlot {
+
+public:
+
+  explicit LockedRepresentationSlot (AtomicRepresentation representation)
+
+      : representation (std::move (representation)) {
+  }
+
+  AtomicRepresentation Load (void) const {
+
+    std::lock_guard<std::mutex> representation_guard (this->representation_lock);
+
+    return this->representation;
+  }
+
+  void Store (AtomicRepresentation desired_representation) {
+
+    std::lock_guard<std::mutex> representation_guard (this->representation_lock);
+
+    this->representation = desired_representation;
+  }
+
+private:
+
+  mutable std::mutex representation_lock;
+
+  AtomicRepresentation representation;
+};
+
+template <typename Slot, typename Handle>
+static void PublishedRepresentation (benchmark::State& state) {
+
+  static Slot published_slot {Handle ()};
+
+  const bool is_writer = state.thread_index () == 0;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      if (is_writer) {
+
+        published_slot.Store (Handle ());
+      }
+      else {
+
+        Handle loaded_representation_object = published_slot.Load ();
+
+        benchmark::DoNotOptimize (loaded_representation_object.GetMessage ().size ());
+      }
+    }
+  }
+
+  const double operations = static_cast<double> (state.iterations ());
+
+  state.counters ["loads"] = benchmark::Counter (is_writer ? 0.0 : operations, benchmark::Counter::kIsRate);
+
+  state.counters ["stores"] = benchmark::Counter (is_writer ? operations : 0.0, benchmark::Counter::kIsRate);
+
+  ReportAllocations (state, state.iterations ());
+}
+
+BENCHMARK_TEMPLATE (PublishedRepresentation, LockedRepresentationSlot, AtomicRepresentation)->ThreadRange (2, 16)->UseRealTime ();
+
+BENCHMARK_TEMPLATE (PublishedRepresentation, RepresentationSlot, HazardRepresentation)->ThreadRange (2, 16)->UseRealTime ();
+
+
+struct CopiedRead {
+
+  static std::size_t Read (void) {
+
+    static HazardRepresentation shared_representation_object;
+
+    HazardRepresentation copied_representation_object (shared_representation_object);
+
+    return copied_representation_object.GetMessage ().size ();
+  }
+};
+
+static RepresentationSlot& ReadSlot (void) {
+
+  static RepresentationSlot read_slot {HazardRepresentation ()};
+
+  return read_slot;
+}
+
+struct LoadedRead {
+
+  static std::size_t Read (void) {
+
+    HazardRepresentation loaded_representation_object = ReadSlot ().Load ();
+
+    return loaded_representation_object.GetMessage ().size ();
+  }
+};
+
+struct BorrowedRead {
+
+  static std::size_t Read (void) {
+
+    BorrowedRepresentation borrowed_representation_object = ReadSlot ().Borrow ();
+
+    return borrowed_representation_object.GetMessage ().size ();
+  }
+};
+
+template <typename ReadPolicy>
+static void ReadContention (benchmark::State& state) {
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      benchmark::DoNotOptimize (ReadPolicy::Read ());
+    }
+  }
+
+  state.SetItemsProcessed (state.iterations ());
+
+  ReportAllocations (state, state.iterations ());
+}
+
+BENCHMARK_TEMPLATE (ReadContention, CopiedRead)->ThreadRange (1, 32)->UseRealTime ();
+
+BENCHMARK_TEMPLATE (ReadContention, LoadedRead)->ThreadRange (1, 32)->UseRealTime ();
+
+BENCHMARK_TEMPLATE (ReadContention, BorrowedRead)->ThreadRange (1, 32)->UseRealTime ();
+
+
+static int64_t increment_count = 0;
+
+static int64_t decrement_count = 0;
+
+class TrafficCounting {
+
+public:
+
+  using Counter = SingleThreadedCounting::Counter;
+
+  static constexpr bool thread_safe = SingleThreadedCounting::thread_safe;
+
+  using WeakCounting = TrafficCounting;
+
+  static void Increment (Counter& counter) noexcept {
+
+    ++increment_count;
+
+    SingleThreadedCounting::Increment (counter);
+  }
+
+  static bool Decrement (Counter& counter) noexcept {
+
+    ++decrement_count;
+
+    return SingleThreadedCounting::Decrement (counter);
+  }
+
+  static int64_t Sample (const Counter& counter) noexcept {
+
+    return SingleThreadedCounting::Sample (counter);
+  }
+
+  static void Bind (Counter& counter, void* body, void (*reclaim) (void*)) noexcept {
+
+    SingleThreadedCounting::Bind (counter, body, reclaim);
+  }
+};
+
+using TrafficRepresentation = BasicRepresentation<TrafficCounting>;
+
+// Declaring the copy operations suppresses the implicit move operations, so the vector has to copy.
+class CopyOnlyRepresentation {
+
+public:
+
+  CopyOnlyRepresentation (void) = default;
+
+  CopyOnlyRepresentation (const CopyOnlyRepresentation&) = default;
+
+  CopyOnlyRepresentation& operator= (const CopyOnlyRepresentation&) = default;
+
+  TrafficRepresentation representation;
+};
+
+template <typename Handle>
+static void PushBack (benchmark::State& state) {
+
+  Handle prototype;
+
+  increment_count = 0;
+
+  decrement_count = 0;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      std::vector<Handle> handles;
+
+      for (int64_t index = 0; index < state.range (0); ++index) {
+
+        handles.push_back (prototype);
+      }
+
+      benchmark::DoNotOptimize (handles.data ());
+    }
+  }
+
+  const double pushed_handles = static_cast<double> (state.iterations ()) * state.range (0);
+
+  state.counters ["increments"] = increment_count / pushed_handles;
+
+  state.counters ["decrements"] = decrement_count / pushed_handles;
+
+  state.SetItemsProcessed (state.iterations () * state.range (0));
+
+  ReportAllocations (state, state.iterations () * state.range (0));
+}
+
+BENCHMARK_TEMPLATE (PushBack, CopyOnlyRepresentation)->Arg (1 << 22)->Unit (benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE (PushBack, TrafficRepresentation)->Arg (1 << 22)->Unit (benchmark::kMillisecond);
+
+
+static int64_t body_count = 0;
+
+class BodyCounting {
+
+public:
+
+  using Counter = SingleThreadedCounting::Counter;
+
+  static constexpr bool thread_safe = SingleThreadedCounting::thread_safe;
+
+  using WeakCounting = BodyCounting;
+
+  // A body's count leaves zero exactly once, when its first representation takes it, so counting those increments counts bodies.
+  static void Increment (Counter& counter) noexcept {
+
+    if (counter == 0) {
+
+      ++body_count;
+    }
+
+    SingleThreadedCounting::Increment (counter);
+  }
+
+  static bool Decrement (Counter& counter) noexcept {
+
+    return SingleThreadedCounting::Decrement (counter);
+  }
+
+  static bool IsShared (const Counter& counter) noexcept {
+
+    return SingleThreadedCounting::IsShared (counter);
+  }
+
+  static int64_t Sample (const Counter& counter) noexcept {
+
+    return SingleThreadedCounting::Sample (counter);
+  }
+
+  static void Bind (Counter& counter, void* body, void (*reclaim) (void*)) noexcept {
+
+    SingleThreadedCounting::Bind (counter, body, reclaim);
+  }
+};
+
+using BodyCountingRepresentation = BasicRepresentation<BodyCounting>;
+
+struct EagerCopy {
+
+  static BodyCountingRepresentation HandOut (const BodyCountingRepresentation& shared_representation_object) {
+
+    BodyCountingRepresentation own_representation_object;
+
+    own_representation_object.SetMessage (shared_representation_object.GetMessage ());
+
+    return own_representation_object;
+  }
+};
+
+struct CopyOnWrite {
+
+  static BodyCountingRepresentation HandOut (const BodyCountingRepresentation& shared_representation_object) {
+
+    return shared_representation_object;
+  }
+};
+
+template <typename HandOutPolicy>
+static void ReadHeavyTrace (benchmark::State& state) {
+
+  constexpr std::size_t trace_length = 1 << 16;
+
+  std::vector<bool> trace (trace_length);
+
+  std::mt19937_64 random_engine (42);
+
+  for (std::size_t step = 0; step < trace_length; ++step) {
+
+    trace [step] = static_cast<int64_t> (random_engine () % 1000) < state.range (0);
+  }
+
+  const std::string written_message = "Behaviour is executed from a body that was written to by one of its callers";
+
+  BodyCountingRepresentation shared_representation_object;
+
+  body_count = 0;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      for (bool is_write : trace) {
+
+        BodyCountingRepresentation own_representation_object = HandOutPolicy::HandOut (shared_representation_object);
+
+        if (is_write) {
+
+          own_representation_object.SetMessage (written_message);
+        }
+        else {
+
+          benchmark::DoNotOptimize (own_representation_object.GetMessage ().size ());
+        }
+      }
+    }
+  }
+
+  const double steps = static_cast<double> (state.iterations ()) * trace_length;
+
+  state.counters ["body_copies"] = body_count / steps;
+
+  state.counters ["copies_avoided"] = 1.0 - body_count / steps;
+
+  state.SetItemsProcessed (state.iterations () * trace_length);
+
+  ReportAllocations (state, state.iterations () * trace_length);
+}
+
+BENCHMARK_TEMPLATE (ReadHeavyTrace, EagerCopy)->Arg (0)->Arg (10)->Arg (100);
+
+BENCHMARK_TEMPLATE (ReadHeavyTrace, CopyOnWrite)->Arg (0)->Arg (10)->Arg (100);
+
+
+template <typename Handle>
+static void ReleaseLatency (benchmark::State& state) {
+
+  std::vector<double> release_latencies;
+
+  release_latencies.reserve (state.max_iterations);
+
+  for (auto _ : state) {
+
+    Handle representation_object;
+
+    representation_object.SetMessage (std::string ((release_latencies.size () % 64 == 0) ? state.range (0) : 64, 'x'));
+
+    const auto release_start = std::chrono::steady_clock::now ();
+
+    {
+      CountedAllocations release_allocations (state);
+
+      Handle released_representation_object (std::move (representation_object));
+    }
+
+    const std::chrono::duration<double> release_time = std::chrono::steady_clock::now () - release_start;
+
+    state.SetIterationTime (release_time.count ());
+
+    release_latencies.push_back (release_time.count () * 1e9);
+  }
+
+  std::sort (release_latencies.begin (), release_latencies.end ());
+
+  const auto percentile = [&release_latencies] (double fraction) {
+
+    return release_latencies [static_cast<std::size_t> (fraction * (release_latencies.size () - 1))];
+  };
+
+  state.counters ["p50_ns"] = percentile (0.50);
+
+  state.counters ["p99_ns"] = percentile (0.99);
+
+  state.counters ["p999_ns"] = percentile (0.999);
+
+  state.counters ["max_ns"] = release_latencies.back ();
+
+  ReportAllocations (state, state.iterations ());
+}
+
+BENCHMARK_TEMPLATE (ReleaseLatency, AtomicRepresentation)->Arg (1 << 20)->Arg (1 << 23)->Iterations (1 << 14)->UseManualTime ();
+
+BENCHMARK_TEMPLATE (ReleaseLatency, DeferredRepresentation)->Arg (1 << 20)->Arg (1 << 23)->Iterations (1 << 14)->UseManualTime ();
+
+
+// Lifecycle suite (LifecycleBenchmarks.hpp).
+
+BENCHMARK_TEMPLATE (Construction, Representation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Construction, AtomicRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Construction, BiasedRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Copying, Representation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Copying, AtomicRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Copying, BiasedRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Assignment, Representation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Assignment, AtomicRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Assignment, BiasedRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Destruction, Representation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Destruction, AtomicRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Destruction, BiasedRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Dispatch, Representation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Dispatch, AtomicRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Dispatch, BiasedRepresentation)->Apply (LifecycleRuns);
+
+
+BENCHMARK_MAIN ();
@@ -0,0 +1,482 @@
+#include <atomic>
+#include <cassert>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "CountedBody.hpp"
+#include "CountedHandle.hpp"
+#include "RepresentationSlot.hpp"
+
+
+template <typename RepresentationType>
+bool SharesBody (const RepresentationType& first_representation, const RepresentationType& second_representation) {
+
+  return &first_representation.GetMessage () == &second_representation.GetMessage ();
+}
+
+// Assignment has to leave every count where copying would have: untouched when the body is already shared, one more on the assigned
+// body and one less on the released one otherwise.
+
+// Self-assignment of the sole representation of a body.
+template <typename RepresentationType>
+void CheckSelfAssignment (void) {
+
+  RepresentationType self_representation;
+
+  const std::string* self_message = &self_representation.GetMessage ();
+
+  RepresentationType& same_representation = self_representation;
+
+  self_representation = same_representation;
+
+  assert (self_representation.UseCount () == 1 && &self_representation.GetMessage () == self_message);
+}
+
+// Assignment between representations that already share a body.
+template <typename RepresentationType>
+void CheckSameBodyAssignment (void) {
+
+  RepresentationType first_representation;
+
+  RepresentationType second_representation (first_representation);
+
+  assert (first_representation.UseCount () == 2);
+
+  second_representation = first_representation;
+
+  assert (first_representation.UseCount () == 2 && SharesBody (first_representation, second_representation));
+}
+
+// Assignment onto another body releases it.
+template <typename RepresentationType>
+void CheckOtherBodyAssignment (void) {
+
+  RepresentationType first_representation;
+
+  RepresentationType other_representation;
+
+  RepresentationType other_copy (other_representation);
+
+  other_representation = first_representation;
+
+  assert (first_representation.UseCount () == 2 && SharesBody (other_representation, first_representation));
+
+  assert (other_copy.UseCount () == 1 && !SharesBody (other_copy, first_representation));
+}
+
+// Chained assignment ends with every representation on the rightmost body.
+template <typename RepresentationType>
+void CheckChainedAssignment (void) {
+
+  RepresentationType chain_first;
+
+  RepresentationType chain_second;
+
+  RepresentationType chain_third;
+
+  chain_first = chain_second = chain_third;
+
+  assert (chain_third.UseCount () == 3 && SharesBody (chain_first, chain_third) && SharesBody (chain_second, chain_third));
+
+  RepresentationType other_representation;
+
+  chain_first = chain_second = other_representation;
+
+  assert (other_representation.UseCount () == 3 && chain_third.UseCount () == 1);
+
+  assert (SharesBody (chain_first, other_representation) && SharesBody (chain_second, other_representation));
+}
+
+template <typename RepresentationType>
+void CheckAssignment (void) {
+
+  CheckSelfAssignment<RepresentationType> ();
+
+  CheckSameBodyAssignment<RepresentationType> ();
+
+  CheckOtherBodyAssignment<RepresentationType> ();
+
+  CheckChainedAssignment<RepresentationType> ();
+}
+
+// Threads assign a shared representation and their own back and forth; once they are done, the shared body has to be counted exactly
+// once per representation left holding it.
+template <typename RepresentationType>
+void CheckCrossThreadAssignment (void) {
+
+  const int thread_count = 4;
+
+  RepresentationType shared_representation;
+
+  std::vector<RepresentationType> thread_representations (thread_count);
+
+  std::vector<std::thread> threads;
+
+  for (int thread_index = 0; thread_index < thread_count; ++thread_index) {
+
+    threads.emplace_back ([&shared_representation, &thread_representation = thread_representations [thread_index]] (void) {
+
+      RepresentationType own_representation;
+
+      for (int round = 0; round < 1000; ++round) {
+
+        thread_representation = shared_representation;
+
+        thread_representation = own_representation;
+      }
+
+      thread_representation = shared_representation;
+
+      assert (own_representation.UseCount () == 1);
+    });
+  }
+
+  for (std::thread& thread : threads) {
+
+    thread.join ();
+  }
+
+  assert (shared_representation.UseCount () == 1 + thread_count);
+
+  for (const RepresentationType& thread_representation : thread_representations) {
+
+    assert (SharesBody (thread_representation, shared_representation));
+  }
+
+  thread_representations.clear ();
+
+  assert (shared_representation.UseCount () == 1);
+}
+
+
+
+// Bodies whose last weak reference went, which for bodies no weak representation watches are the bodies reclaimed.
+static std::atomic<int64_t> reclaimed_body_count (0);
+
+class ReclaimCountingWeakCounting : public AtomicCounting {
+
+public:
+
+  static bool Decrement (Counter& counter) noexcept {
+
+    if (!AtomicCounting::Decrement (counter)) {
+
+      return false;
+    }
+
+    reclaimed_body_count.fetch_add (1, std::memory_order_relaxed);
+
+    return true;
+  }
+};
+
+// Atomic counting that counts reclaimed bodies.
+class ReclaimCounting : public AtomicCounting {
+
+public:
+
+  using WeakCounting = ReclaimCountingWeakCounting;
+};
+
+using SlotRepresentation = BasicRepresentation<ReclaimCounting, HazardPointerReclamation>;
+
+using Slot = BasicRepresentationSlot<ReclaimCounting>;
+
+static SlotRepresentation CreateSlotRepresentation (const std::string& message) {
+
+  SlotRepresentation representation;
+
+  representation.SetMessage (message);
+
+  return representation;
+}
+
+// A failed compare-and-exchange hands back what the slot holds instead, a successful one releases the slot's reference to the expected
+// body, and an exchange hands that reference to the caller.
+void CheckSlotReplacement (void) {
+
+  SlotRepresentation first_representation = CreateSlotRepresentation ("First");
+
+  Slot slot (first_representation);
+
+  assert (first_representation.UseCount () == 2);
+
+  SlotRepresentation expected_representation = CreateSlotRepresentation ("Expected");
+
+  assert (!slot.CompareExchange (expected_representation, CreateSlotRepresentation ("Desired")));
+
+  assert (SharesBody (expected_representation, first_representation) && first_representation.UseCount () == 3);
+
+  assert (SharesBody (slot.Load (), first_representation));
+
+  SlotRepresentation second_representation = CreateSlotRepresentation ("Second");
+
+  assert (slot.CompareExchange (expected_representation, second_representation));
+
+  assert (first_representation.UseCount () == 2 && second_representation.UseCount () == 2);
+
+  SlotRepresentation previous_representation = slot.Exchange (CreateSlotRepresentation ("Third"));
+
+  assert (SharesBody (previous_representation, second_representation) && second_representation.UseCount () == 2);
+
+  assert (slot.Load ().GetMessage () == "Third");
+}
+
+// Readers load from a slot while a writer keeps storing new bodies into it. Every body a load returns has to still be alive, with its
+// state intact; the replaced bodies are all reclaimed once nobody reads them any more.
+void CheckSlotLoadRacingStore (void) {
+
+  const int reader_count = 3;
+
+  const int store_count = 2000;
+
+  // Whatever earlier checks retired is reclaimed first, so that only this check's bodies are counted.
+  HazardPointerDomain::Reclaim ();
+
+  const int64_t initial_reclaimed_body_count = reclaimed_body_count.load ();
+
+  {
+    Slot slot (CreateSlotRepresentation ("Body 0"));
+
+    std::atomic<bool> storing (true);
+
+    std::vector<std::thread> readers;
+
+    for (int reader_index = 0; reader_index < reader_count; ++reader_index) {
+
+      readers.emplace_back ([&slot, &storing] (void) {
+
+        do {
+
+          SlotRepresentation loaded_representation = slot.Load ();
+
+          assert (loaded_representation && loaded_representation.UseCount () >= 1);
+
+          assert (loaded_representation.GetMessage ().compare (0, 5, "Body ") == 0);
+
+        } while (storing.load (std::memory_order_acquire));
+      });
+    }
+
+    for (int store_index = 1; store_index <= store_count; ++store_index) {
+
+      slot.Store (CreateSlotRepresentation ("Body " + std::to_string (store_index)));
+    }
+
+    storing.store (false, std::memory_order_release);
+
+    for (std::thread& reader : readers) {
+
+      reader.join ();
+    }
+
+    HazardPointerDomain::Reclaim ();
+
+    assert (reclaimed_body_count.load () - initial_reclaimed_body_count == store_count);
+  }
+
+  HazardPointerDomain::Reclaim ();
+
+  assert (reclaimed_body_count.load () - initial_reclaimed_body_count == store_count + 1);
+}
+
+// A borrowed representation keeps its body readable after the slot moved on and the last representation let go of it, and the body is
+// reclaimed as soon as the borrow ends.
+void CheckBorrowOutlivesOwners (void) {
+
+  HazardPointerDomain::Reclaim ();
+
+  const int64_t initial_reclaimed_body_count = reclaimed_body_count.load ();
+
+  SlotRepresentation owning_representation = CreateSlotRepresentation ("Borrowed");
+
+  Slot slot (owning_representation);
+
+  {
+    BasicBorrowedRepresentation<ReclaimCounting> borrowed_representation = slot.Borrow ();
+
+    assert (borrowed_representation && owning_representation.UseCount () == 2);
+
+    slot.Store (CreateSlotRepresentation ("Replacement"));
+
+    owning_representation = SlotRepresentation ();
+
+    HazardPointerDomain::Reclaim ();
+
+    assert (reclaimed_body_count.load () == initial_reclaimed_body_count);
+
+    assert (borrowed_representation.GetMessage () == "Borrowed" && !borrowed_representation.Lock ());
+  }
+
+  HazardPointerDomain::Reclaim ();
+
+  assert (reclaimed_body_count.load () - initial_reclaimed_body_count == 1);
+}
+
+
+// Biased counting, where the thread that created a body counts its own references apart. The weak representation tells whether the
+// count was found at zero: it can be locked until then, and not after.
+
+// The owner releases last, after another thread copied the body and let go of its copy.
+template <typename RepresentationType, typename WeakRepresentationType>
+void CheckBiasedOwnerReleasesLast (void) {
+
+  RepresentationType owning_representation;
+
+  WeakRepresentationType weak_representation (owning_representation);
+
+  std::thread ([&owning_representation] (void) {
+
+    RepresentationType copied_representation (owning_representation);
+
+    assert (copied_representation);
+  }).join ();
+
+  assert (weak_representation.Lock ());
+
+  {
+    RepresentationType released_representation (std::move (owning_representation));
+  }
+
+  assert (!weak_representation.Lock ());
+}
+
+// Another thread releases last, while the owner is still alive. The counter waits in the owner's queue until the owner merges it; until
+// then a weak representation can still be locked, and the lock keeps the body alive. The owner's next count update merges the counter,
+// finds it at zero and reclaims the body.
+template <typename RepresentationType, typename WeakRepresentationType>
+void CheckBiasedNonOwnerReleasesLast (void) {
+
+  RepresentationType owning_representation;
+
+  WeakRepresentationType weak_representation (owning_representation);
+
+  RepresentationType handed_representation (owning_representation);
+
+  {
+    RepresentationType released_representation (std::move (owning_representation));
+  }
+
+  std::thread ([&handed_representation, &weak_representation] (void) {
+
+    {
+      RepresentationType released_representation (std::move (handed_representation));
+    }
+
+    RepresentationType locked_representation = weak_representation.Lock ();
+
+    assert (locked_representation);
+
+    RepresentationType copied_representation (locked_representation);
+
+    assert (copied_representation);
+  }).join ();
+
+  assert (!weak_representation.Lock ());
+}
+
+// The owner exits while another thread still holds a reference it counted. The release that follows merges the counter itself.
+template <typename RepresentationType, typename WeakRepresentationType>
+void CheckBiasedOwnerExitsFirst (void) {
+
+  std::vector<RepresentationType> handed_representations;
+
+  std::vector<WeakRepresentationType> weak_representations;
+
+  std::thread ([&handed_representations, &weak_representations] (void) {
+
+    RepresentationType owning_representation;
+
+    weak_representations.push_back (WeakRepresentationType (owning_representation));
+
+    handed_representations.push_back (owning_representation);
+  }).join ();
+
+  assert (weak_representations.front ().Lock ());
+
+  handed_representations.clear ();
+
+  assert (!weak_representations.front ().Lock ());
+}
+
+
+int main (void) {
+
+  // Copies share one body until one of them is changed, which detaches it onto a body of its own.
+
+  Representation first_representation;
+
+  Representation second_representation (first_representation);
+
+  assert (&second_representation.GetMessage () == &first_representation.GetMessage ());
+
+  second_representation.SetMessage ("Changed");
+
+  assert (&second_representation.GetMessage () != &first_representation.GetMessage ());
+
+  assert (second_representation.GetMessage () == "Changed" && first_representation.GetMessage () != "Changed");
+
+  // Moving hands the body over and leaves the moved-from representation empty.
+
+  const std::string* first_message = &first_representation.GetMessage ();
+
+  Representation moved_representation (std::move (first_representation));
+
+  assert (!first_representation && moved_representation && &moved_representation.GetMessage () == first_message);
+
+  // A weak representation locks while the body is alive, and not after.
+
+  WeakRepresentation weak_representation (moved_representation);
+
+  assert (weak_representation.Lock ());
+
+  moved_representation = second_representation;
+
+  assert (!weak_representation.Lock ());
+
+  // The same for any value type, through CountedHandle.
+
+  CountedHandle<std::string> first_handle = CountedHandle<std::string>::Create ("value");
+
+  CountedHandle<std::string> second_handle (first_handle);
+
+  assert (&*second_handle == &*first_handle && first_handle.IsShared ());
+
+  second_handle.Mutate () = "mutated";
+
+  assert (*first_handle == "value" && *second_handle == "mutated" && !first_handle.IsShared ());
+
+  CountedHandle<std::string> moved_handle (std::move (first_handle));
+
+  assert (!first_handle && !first_handle.IsShared () && *moved_handle == "value");
+
+  // Assignment, on one thread and across threads.
+
+  CheckAssignment<Representation> ();
+
+  CheckAssignment<AtomicRepresentation> ();
+
+  CheckCrossThreadAssignment<AtomicRepresentation> ();
+
+  CheckCrossThreadAssignment<DeferredRepresentation> ();
+
+  // Representation slots.
+
+  CheckSlotReplacement ();
+
+  CheckSlotLoadRacingStore ();
+
+  CheckBorrowOutlivesOwners ();
+
+  // Biased counting: whichever thread releases last, and whether or not the owner is still around.
+
+  CheckBiasedOwnerReleasesLast<BiasedRepresentation, BiasedWeakRepresentation> ();
+
+  CheckBiasedNonOwnerReleasesLast<BiasedRepresentation, BiasedWeakRepresentation> ();
+
+  CheckBiasedOwnerExitsFirst<BiasedRepresentation, BiasedWeakRepresentation> ();
+
+  return 0;
+}
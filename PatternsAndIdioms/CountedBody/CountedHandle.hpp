@@ -0,0 +1,279 @@
+#ifndef COUNTED_HANDLE_HPP
+#define COUNTED_HANDLE_HPP
+
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "../Common/AllocationTracking.hpp"
+#include "../Common/CountTracking.hpp"
+#include "../Common/Counting.hpp"
+#include "../Common/Reclamation.hpp"
+
+// Counted Handle.
+
+// The Counted Body Idiom for any type, rather than for the one Implementation class of CountedBody.hpp: CountedHandle<Value> shares a
+// body holding a Value and its reference count between all of its copies.
+
+// (*) The counting policy (Counting.hpp) decides which threads may hold copies of a handle, and the reclamation policy (Reclamation.hpp)
+//     where the last release destroys the body. Both are template parameters, so every count update is a direct call the compiler can
+//     inline into the handle; nothing about them is decided at run time.
+
+// (*) Reading goes through *, -> and Get. Changing goes through Mutate, which copies the body on write first if it is still shared.
+
+// (*) Moving hands the body over without touching the count, and assigning a handle that already shares the body costs nothing.
+
+// (*) Bodies come out of the allocator (rebound to the body), as in DetachedHandle.hpp. Each body keeps a copy of it to free itself
+//     with and to allocate its copy on write.
+
+
+template <typename Value, typename CountingPolicy = SingleThreadedCounting, typename ReclamationPolicy = ImmediateReclamation,
+          typename Allocator = std::allocator<Value>>
+class CountedHandle {
+
+  static_assert (CountingPolicy::thread_safe || !ReclamationPolicy::reclaims_elsewhere,
+                 "A body reclaimed on another thread needs a thread-safe counting policy.");
+
+public:
+
+  // A handle to a default constructed value.
+  CountedHandle (void)
+
+      : CountedHandle (AllocateBody (Allocator ())) {
+  }
+
+  // A handle to a value constructed from the arguments.
+  template <typename... Arguments>
+  static CountedHandle Create (Arguments&&... arguments) {
+
+    return CreateWithAllocator (Allocator (), std::forward<Arguments> (arguments)...);
+  }
+
+  template <typename... Arguments>
+  static CountedHandle CreateWithAllocator (const Allocator& allocator, Arguments&&... arguments) {
+
+    return CountedHandle (AllocateBody (allocator, std::forward<Arguments> (arguments)...));
+  }
+
+  CountedHandle (const CountedHandle& another_handle)
+
+      : body (another_handle.body) {
+
+    CLEANCODE_COUNT_EVENT ("CountedBody", copy);
+
+    this->IncrementReferenceCount ();
+  }
+
+  CountedHandle (CountedHandle&& another_handle) noexcept
+
+      : body (another_handle.body) {
+
+    CLEANCODE_COUNT_EVENT ("CountedBody", move);
+
+    another_handle.body = nullptr;
+  }
+
+  ~CountedHandle (void) noexcept {
+
+    this->DecrementReferenceCount ();
+  }
+
+  // The new reference is taken before the old one is let go, so a handle assigned a copy of itself never frees the body on the way.
+  CountedHandle& operator= (const CountedHandle& another_handle) {
+
+    CLEANCODE_COUNT_ASSIGNMENT ("CountedBody", this->body == another_handle.body);
+
+    if (this->body == another_handle.body) {
+
+      return *this;
+    }
+
+    another_handle.IncrementReferenceCount ();
+
+    this->DecrementReferenceCount ();
+
+    this->body = another_handle.body;
+
+    return *this;
+  }
+
+  CountedHandle& operator= (CountedHandle&& another_handle) noexcept {
+
+    CLEANCODE_COUNT_EVENT ("CountedBody", move_assignment);
+
+    if (this == &another_handle) {
+
+      return *this;
+    }
+
+    this->DecrementReferenceCount ();
+
+    this->body = another_handle.body;
+
+    another_handle.body = nullptr;
+
+    return *this;
+  }
+
+  // False for a moved-from handle.
+  explicit operator bool (void) const noexcept {
+
+    return this->body != nullptr;
+  }
+
+  const Value& Get (void) const noexcept {
+
+    return this->body->value;
+  }
+
+  const Value& operator* (void) const noexcept {
+
+    return this->body->value;
+  }
+
+  const Value* operator-> (void) const noexcept {
+
+    return &this->body->value;
+  }
+
+  // The value, for changing: a body that is still shared is copied first, so no other handle sees the change.
+  Value& Mutate (void) {
+
+    this->Detach ();
+
+    return this->body->value;
+  }
+
+  // False for a moved-from handle, which shares nothing.
+  bool IsShared (void) const noexcept {
+
+    return this->body != nullptr && CountingPolicy::IsShared (this->body->count);
+  }
+
+private:
+
+  struct Body : TrackedCount {
+
+    template <typename... Arguments>
+    explicit Body (const Allocator& allocator, Arguments&&... arguments)
+
+        : TrackedCount (1)
+
+        , count (1)
+
+        , allocator (allocator)
+
+        , value (std::forward<Arguments> (arguments)...) {
+    }
+
+    typename CountingPolicy::Counter count;
+
+    RetireEntry retire_entry;
+
+    Allocator allocator;
+
+    Value value;
+  };
+
+  // Adopts a body whose count already holds this handle's reference.
+  explicit CountedHandle (Body* body)
+
+      : body (body) {
+
+    CountingPolicy::Bind (this->body->count, this->body, &CountedHandle::RetireBody);
+  }
+
+  Body* body;
+
+  using BodyAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Body>;
+
+  // If the value fails to construct, its block is freed before the exception goes on.
+  template <typename... Arguments>
+  static Body* AllocateBody (const Allocator& allocator, Arguments&&... arguments) {
+
+    BodyAllocator body_allocator (allocator);
+
+    Body* body = std::allocator_traits<BodyAllocator>::allocate (body_allocator, 1);
+
+    try {
+
+      ::new (static_cast<void*> (body)) Body (allocator, std::forward<Arguments> (arguments)...);
+    }
+    catch (...) {
+
+      std::allocator_traits<BodyAllocator>::deallocate (body_allocator, body, 1);
+
+      throw;
+    }
+
+    CLEANCODE_COUNT_ALLOCATION ("CountedBody", "CountedHandle::AllocateBody", sizeof (Body));
+
+    return body;
+  }
+
+  // The copy is made before the shared body is let go, so a value that fails to copy leaves the handle as it was. A moved-from handle
+  // has nothing to detach.
+  void Detach (void) {
+
+    if (this->body == nullptr || !CountingPolicy::IsShared (this->body->count)) {
+
+      return;
+    }
+
+    CountedHandle detached_handle (AllocateBody (this->body->allocator, std::as_const (this->body->value)));
+
+    *this = std::move (detached_handle);
+  }
+
+  void IncrementReferenceCount (void) const noexcept {
+
+    if (this->body == nullptr) {
+
+      return;
+    }
+
+    CountingPolicy::Increment (this->body->count);
+
+    CLEANCODE_COUNT_INCREMENT ("CountedBody", *this->body, CountingPolicy::Sample (this->body->count));
+  }
+
+  void DecrementReferenceCount (void) {
+
+    if (this->body == nullptr) {
+
+      return;
+    }
+
+    CLEANCODE_COUNT_DECREMENT ("CountedBody");
+
+    if (CountingPolicy::Decrement (this->body->count)) {
+
+      RetireBody (this->body);
+    }
+
+    this->body = nullptr;
+  }
+
+  static void RetireBody (void* body) {
+
+    CLEANCODE_COUNT_RELEASE ("CountedBody", *static_cast<Body*> (body));
+
+    ReclamationPolicy::Retire (static_cast<Body*> (body)->retire_entry, body, &CountedHandle::ReclaimBody);
+  }
+
+  // The allocator is moved out of the body before the body is destroyed, and frees it afterwards.
+  static void ReclaimBody (void* body) {
+
+    Body* reclaimed_body = static_cast<Body*> (body);
+
+    BodyAllocator body_allocator (std::move (reclaimed_body->allocator));
+
+    reclaimed_body->~Body ();
+
+    std::allocator_traits<BodyAllocator>::deallocate (body_allocator, reclaimed_body, 1);
+
+    CLEANCODE_COUNT_FREE ("CountedBody", "CountedHandle::ReclaimBody", sizeof (Body));
+  }
+};
+
+#endif
@@ -0,0 +1,220 @@
+#ifndef REPRESENTATION_SLOT_HPP
+#define REPRESENTATION_SLOT_HPP
+
+#include <atomic>
+#include <string>
+#include <utility>
+
+#include "CountedBody.hpp"
+#include "../Common/CountTracking.hpp"
+#include "../Common/Counting.hpp"
+#include "../Common/HazardPointers.hpp"
+#include "../Common/OutputSink.hpp"
+#include "../Common/Reclamation.hpp"
+
+// Representation Slot.
+
+// An atomic variable holding a representation: any number of threads load representations out of the slot while others replace the one
+// it holds, and nobody takes a lock.
+
+// (*) The slot owns one reference to the body it holds. Storing swaps the new body's pointer in and releases the old body's reference,
+//     exchanging hands that reference to the caller instead, and a compare-and-exchange only swaps if the slot still holds the body the
+//     caller expects.
+
+// (*) A reader can't simply increment the count of the body it finds in the slot: by the time it does, a writer may have replaced the
+//     body and released its last reference. The reader protects the body with a hazard pointer (HazardPointers.hpp) first, so that it
+//     stays allocated, and then only takes a reference if its count is still above zero; otherwise the slot already holds another body,
+//     and the reader tries again. A load is lock-free, not wait-free: it retries only when a writer got in between.
+
+// (*) A reader that only looks at the body for a moment doesn't need a reference either: borrowing from the slot hands out the body under
+//     the hazard pointer alone, so the read never writes to the body's count (and never contends for it with other readers). The body
+//     stays readable for as long as the borrowed representation lives, even if the slot moves on meanwhile, and a representation that
+//     ends up holding the body's last reference still copies it before changing it. Borrowed representations are meant to live on the
+//     stack of one thread, for the length of a read; Lock turns one into a representation that can be kept.
+
+// (*) That protection only holds if bodies are reclaimed once no hazard pointer protects them, so a slot holds representations with
+//     hazard pointer reclamation (Reclamation.hpp). Their count has to be thread-safe, and atomic counting is the default.
+
+
+// Reads the body a slot held when it was borrowed from, without owning it.
+template <typename CountingPolicy>
+class BasicBorrowedRepresentation {
+
+  friend class BasicRepresentationSlot<CountingPolicy>;
+
+public:
+
+  BasicBorrowedRepresentation (const BasicBorrowedRepresentation&) = delete;
+
+  BasicBorrowedRepresentation& operator= (const BasicBorrowedRepresentation&) = delete;
+
+  BasicBorrowedRepresentation (BasicBorrowedRepresentation&& another_borrowed_representation) noexcept
+
+      : hazard_pointer (std::move (another_borrowed_representation.hazard_pointer))
+
+      , implementation (another_borrowed_representation.implementation) {
+
+    another_borrowed_representation.implementation = nullptr;
+  }
+
+  // False if the slot was empty.
+  explicit operator bool (void) const noexcept {
+
+    return this->implementation != nullptr;
+  }
+
+  void ExecuteBehaviour (void) const {
+
+    this->implementation->Behaviour ();
+
+    Output () << "\tBorrowed representation address: " << this << " || Implementation address: " << this->implementation << '\n';
+  }
+
+  const std::string& GetMessage (void) const {
+
+    return this->implementation->message;
+  }
+
+  // A representation of the borrowed body if some representation (or the slot) still holds it, an empty one otherwise.
+  BasicRepresentation<CountingPolicy, HazardPointerReclamation> Lock (void) const {
+
+    if (this->implementation == nullptr || !CountingPolicy::IncrementIfNonZero (this->implementation->reference_count)) {
+
+      return BasicRepresentation<CountingPolicy, HazardPointerReclamation> (nullptr);
+    }
+
+    CLEANCODE_COUNT_INCREMENT ("CountedBody", *this->implementation, CountingPolicy::Sample (this->implementation->reference_count));
+
+    return BasicRepresentation<CountingPolicy, HazardPointerReclamation> (this->implementation);
+  }
+
+private:
+
+  BasicBorrowedRepresentation (HazardPointer hazard_pointer, BasicImplementation<CountingPolicy>* implementation) noexcept
+
+      : hazard_pointer (std::move (hazard_pointer))
+
+      , implementation (implementation) {
+  }
+
+  HazardPointer hazard_pointer;
+
+  BasicImplementation<CountingPolicy>* implementation;
+};
+
+
+template <typename CountingPolicy = AtomicCounting>
+class BasicRepresentationSlot {
+
+public:
+
+  using HeldRepresentation = BasicRepresentation<CountingPolicy, HazardPointerReclamation>;
+
+  // An empty slot; loading from it gives an empty representation.
+  BasicRepresentationSlot (void) noexcept
+
+      : implementation (nullptr) {
+  }
+
+  explicit BasicRepresentationSlot (HeldRepresentation representation) noexcept
+
+      : implementation (representation.implementation) {
+
+    representation.implementation = nullptr;
+  }
+
+  BasicRepresentationSlot (const BasicRepresentationSlot&) = delete;
+
+  BasicRepresentationSlot& operator= (const BasicRepresentationSlot&) = delete;
+
+  // Nobody else may use the slot any more, so its reference is released like any representation's.
+  ~BasicRepresentationSlot (void) noexcept {
+
+    HeldRepresentation released_representation (this->implementation.load (std::memory_order_acquire));
+  }
+
+  // A representation of the body the slot holds right now.
+  HeldRepresentation Load (void) const {
+
+    HazardPointer hazard_pointer;
+
+    while (true) {
+
+      BasicImplementation<CountingPolicy>* loaded_implementation = hazard_pointer.Protect (this->implementation);
+
+      if (loaded_implementation == nullptr) {
+
+        return HeldRepresentation (nullptr);
+      }
+
+      // A count at zero means the body was already replaced and released, so the slot holds another one by now.
+      if (CountingPolicy::IncrementIfNonZero (loaded_implementation->reference_count)) {
+
+        CLEANCODE_COUNT_INCREMENT ("CountedBody", *loaded_implementation, CountingPolicy::Sample (loaded_implementation->reference_count));
+
+        return HeldRepresentation (loaded_implementation);
+      }
+    }
+  }
+
+  // A borrowed representation of the body the slot holds right now; its count isn't touched.
+  BasicBorrowedRepresentation<CountingPolicy> Borrow (void) const {
+
+    HazardPointer hazard_pointer;
+
+    BasicImplementation<CountingPolicy>* borrowed_implementation = hazard_pointer.Protect (this->implementation);
+
+    return BasicBorrowedRepresentation<CountingPolicy> (std::move (hazard_pointer), borrowed_implementation);
+  }
+
+  void Store (HeldRepresentation desired_representation) {
+
+    this->Exchange (std::move (desired_representation));
+  }
+
+  // Stores the representation and hands back the one the slot held before.
+  HeldRepresentation Exchange (HeldRepresentation desired_representation) {
+
+    BasicImplementation<CountingPolicy>* previous_implementation = this->implementation.exchange (desired_representation.implementation,
+                                                                                                 std::memory_order_seq_cst);
+
+    desired_representation.implementation = nullptr;
+
+    return HeldRepresentation (previous_implementation);
+  }
+
+  // Stores the desired representation if the slot still holds the expected one's body, and returns true. Otherwise the expected
+  // representation is replaced by what the slot holds now, and the result is false.
+  bool CompareExchange (HeldRepresentation& expected_representation, HeldRepresentation desired_representation) {
+
+    BasicImplementation<CountingPolicy>* expected_implementation = expected_representation.implementation;
+
+    if (this->implementation.compare_exchange_strong (expected_implementation, desired_representation.implementation,
+                                                      std::memory_order_seq_cst)) {
+
+      desired_representation.implementation = nullptr;
+
+      // The slot's reference to the expected body, released on the way out.
+      HeldRepresentation previous_representation (expected_implementation);
+
+      return true;
+    }
+
+    expected_representation = this->Load ();
+
+    return false;
+  }
+
+private:
+
+  // Sequentially consistent replacements, so that a scan that follows one can't miss a reader's hazard pointer (see HazardPointers.hpp).
+  std::atomic<BasicImplementation<CountingPolicy>*> implementation;
+};
+
+
+// Slots of atomically counted representations.
+using RepresentationSlot = BasicRepresentationSlot<>;
+
+using BorrowedRepresentation = BasicBorrowedRepresentation<AtomicCounting>;
+
+#endif
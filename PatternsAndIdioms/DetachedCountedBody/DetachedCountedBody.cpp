@@ -1,151 +1,113 @@
-#include <iostream>
-#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
-// Detached Counted Body Idiom.
+#include "DetachedCountedBody.hpp"
+#include "DetachedHandle.hpp"
 
-// Motivation:
 
-// (1) With the Counted Body Idiom, we've seen how we can be fairly efficient with large object copies through the use of reference counts. 
-//     In general, however, developers have to work with library objects with no support for reference counting whatsoever. If the library
-//     is too good to pass up, a typical fix is to create a wrapper class that has a reference count as a field and delegates all method calls
-//     to the library code. This is can be good but, concerning efficiency, each method call has a "CALL" overhead attached to it. Not a big
-//     but it kinda defeats the purpose of being efficient with copies if we're not efficient with a simple call.
-
-// (Better) Solution:
-
-// (*) Design the representation object such that there is a separate reference counter object and a separate implementation object.
+int main (int arg_count, char* arg_vector []) {
 
-// (*) When a copy is initiated, both the references to the reference counter object and implementation object is copied.
+  // Demo of Detached Counted Body Idiom.
 
-// (*) Just like in Counted Body, once the reference counter hits zero or lower, we deallocate the implementation object, but in this case,
-//     along with the reference counter object.
+  // Using Empty Constructor:
+  Representation first_representation_object;
 
-// (*) Just like in Counted Body, leave all the memory management to the representation object.
+  first_representation_object.ExecuteBehaviour ();
 
-// Structure:
+  // Using Copy Constructor:
+  Representation second_representation_object = first_representation_object;
 
+  second_representation_object.ExecuteBehaviour ();
 
-class LibraryObject {
+  // Using Assignment Operator:
+  Representation third_representation_object;
 
-  friend class Representation;
+  third_representation_object = second_representation_object;
 
-private:
+  third_representation_object.ExecuteBehaviour ();
 
-  LibraryObject (void) {
-  }
-  
-  ~LibraryObject (void) noexcept {
-  }
+  // Using the single allocation factory (note how close the counter and library object addresses are):
+  Representation fourth_representation_object = Representation::CreateSingleAllocation ();
 
-  void Behaviour (void) const {
-  
-    std::cout << "Behaviour executed from an unmodifiable Library Object from the Representation class.\n";
-  }
-};
+  fourth_representation_object.ExecuteBehaviour ();
 
+  // Using Move Constructor (same counter and library object, no count update):
+  Representation fifth_representation_object = std::move (fourth_representation_object);
 
+  fifth_representation_object.ExecuteBehaviour ();
 
-class Representation {
+  // Using a Weak Representation (it can only be locked while some representation still holds the library object):
+  Representation sixth_representation_object = Representation::CreateSingleAllocation ();
 
-public:
+  WeakRepresentation weak_representation_object = sixth_representation_object;
 
-  Representation (void) 
+  if (Representation locked_representation_object = weak_representation_object.Lock ()) {
 
-      : implementation (new LibraryObject ())
-      
-      , reference_count (new int64_t (1)) {
+    locked_representation_object.ExecuteBehaviour ();
   }
 
-  Representation (const Representation& another_representation) {
-    
-    this->implementation  = another_representation.implementation;
+  sixth_representation_object = fifth_representation_object;
 
-    this->reference_count = another_representation.reference_count;
+  if (!weak_representation_object.Lock ()) {
 
-    this->IncrementReferenceCount ();
+    Output () << "The Weak Representation can't be locked once its library object is gone.\n";
   }
 
-  ~Representation (void) noexcept {
-  
-    this->DecrementReferenceCount ();
-  }
+  // Using Assignment between representations that already share a library object (the sole representation of one assigned to itself
+  // included): no count is touched. Assignments return the representation they assigned to, so they chain:
+  Representation seventh_representation_object;
 
-  void operator= (const Representation& another_representation) {
-    
-    this->DecrementReferenceCount ();
+  Representation& same_representation_object = seventh_representation_object;
 
-    this->implementation = another_representation.implementation;
+  seventh_representation_object = same_representation_object;
 
-    this->reference_count = another_representation.reference_count;
+  Representation eighth_representation_object;
 
-    this->IncrementReferenceCount ();
-  }
+  Representation ninth_representation_object;
 
-  void ExecuteBehaviour (void) {
-    
-    this->implementation->Behaviour ();
-    
-    std::cout << "\tRepresentation Addresss: " << this 
+  ninth_representation_object = eighth_representation_object = seventh_representation_object;
 
-        << " || Reference Counter Address: " << this->reference_count 
+  ninth_representation_object.ExecuteBehaviour ();
 
-        << " || Library Object Implementation Address: " << this->implementation
+  // Using Assignment from two threads at once, one of them assigning the library object its representation already shares:
+  AtomicRepresentation shared_representation_object;
 
-        << '\n';
-  }
-
-
-private:  
-
-  LibraryObject* implementation;
+  AtomicRepresentation other_representation_object;
 
-  int64_t* reference_count;
+  std::thread worker ([&shared_representation_object] () {
 
-  void DecrementReferenceCount  (void) {
-    
-    --(*this->reference_count);
+    AtomicRepresentation worker_representation_object = shared_representation_object;
 
-    if (*this->reference_count > 0) {
-      return;
-    }
+    worker_representation_object = shared_representation_object;
+  });
 
-    delete this->implementation;
+  AtomicRepresentation main_representation_object = other_representation_object;
 
-    this->implementation = nullptr;
+  main_representation_object = shared_representation_object;
 
-    delete this->reference_count;
+  worker.join ();
 
-    this->implementation = nullptr;
-  }
+  // Using Biased Counting (this thread created the library object, so copies made here never touch an atomic count):
+  BiasedRepresentation biased_representation_object;
 
-  void IncrementReferenceCount (void) {
-    
-    ++(*this->reference_count);
-  }
-};
+  BiasedRepresentation copied_biased_representation_object = biased_representation_object;
 
+  copied_biased_representation_object.ExecuteBehaviour ();
 
+  // Using Sharded Counting (the copy is counted in this thread's slot of the count, which no other thread touches):
+  ShardedRepresentation sharded_representation_object;
 
-int main (int arg_count, char* arg_vector []) {
- 
-  // Demo of Detached Counted Body Idiom.
-  
-  // Using Empty Constructor: 
-  Representation first_representation_object;    
- 
-  first_representation_object.ExecuteBehaviour ();
-  
-  // Using Copy Constructor:
-  Representation second_representation_object = first_representation_object;
+  ShardedRepresentation copied_sharded_representation_object = sharded_representation_object;
 
-  second_representation_object.ExecuteBehaviour ();
+  copied_sharded_representation_object.ExecuteBehaviour ();
 
-  // Using Assignment Operator:
-  Representation third_representation_object;
+  // Using a detached handle (any type can be counted from the outside; here an existing std::vector, adopted by atomic handles):
+  DetachedHandle<std::vector<int>, AtomicCounting> vector_handle (new std::vector<int> {1, 2, 3});
 
-  third_representation_object = second_representation_object;
+  DetachedHandle<std::vector<int>, AtomicCounting> copied_vector_handle = vector_handle;
 
-  third_representation_object.ExecuteBehaviour ();
+  Output () << "The adopted std::vector holds " << copied_vector_handle->size () << " elements.\n";
 
   return 0;
 }
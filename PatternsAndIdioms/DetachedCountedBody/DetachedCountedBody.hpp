@@ -0,0 +1,519 @@
+#ifndef DETACHED_COUNTED_BODY_HPP
+#define DETACHED_COUNTED_BODY_HPP
+
+#include <cstdint>
+#include <new>
+#include <string>
+
+#include "../Common/AllocationTracking.hpp"
+#include "../Common/CountTracking.hpp"
+#include "../Common/Counting.hpp"
+#include "../Common/OutputSink.hpp"
+
+// Detached Counted Body Idiom.
+
+// Motivation:
+
+// (1) With the Counted Body Idiom, we've seen how we can be fairly efficient with large object copies through the use of reference counts.
+//     In general, however, developers have to work with library objects with no support for reference counting whatsoever. If the library
+//     is too good to pass up, a typical fix is to create a wrapper class that has a reference count as a field and delegates all method calls
+//     to the library code. This is can be good but, concerning efficiency, each method call has a "CALL" overhead attached to it. Not a big
+//     but it kinda defeats the purpose of being efficient with copies if we're not efficient with a simple call.
+
+// (Better) Solution:
+
+// (*) Design the representation object such that there is a separate reference counter object and a separate implementation object.
+
+// (*) When a copy is initiated, both the references to the reference counter object and implementation object is copied.
+
+// (*) Just like in Counted Body, once the reference counter hits zero or lower, we deallocate the implementation object, but in this case,
+//     along with the reference counter object.
+
+// (*) Just like in Counted Body, leave all the memory management to the representation object.
+
+// (*) Being "detached" only means the library object doesn't know about the count; it doesn't mean they have to live in separate
+//     allocations. If the representation creates the library object itself, it can place the count and the object side by side in one
+//     block (the same trick std::make_shared plays): one allocation instead of two, and the count sits next to the object it guards.
+//     The count carries the functions that destroy and free its layout, so the last representation frees the right thing.
+
+// (*) A representation that is about to die doesn't need to share its body, it can hand it over. Moving a representation steals both
+//     pointers and leaves the source empty, so returning by value or relocating representations inside a container costs no count updates.
+
+// (*) Assigning a representation that already shares the library object does nothing at all, so neither count traffic nor a
+//     self-assignment can release it on the way. Any other assignment takes its new reference before it lets go of the old one.
+
+// (*) A weak representation refers to the library object without keeping it alive, so a cache can hold it without pinning memory. The
+//     count object keeps a weak count next to the strong one: the last representation destroys the library object, the last weak one
+//     frees the count object (and with it the single allocation, if that's how they were created). Lock turns a weak representation
+//     back into a representation as long as the library object is still alive.
+
+// (*) Both counts are updated through a counting policy (Counting.hpp), as in Counted Body: a plain integer for representations that
+//     stay on one thread, an atomic count for ones that don't, or biased counting, where the thread that created the library object
+//     counts in a plain integer and only the other threads pay for atomic updates.
+
+// (*) For the few library objects that every core copies at once, even the atomic count is too much: each update pulls its cache line
+//     away from every other core. Sharded counting gives each thread a cache line of its own in the count object and only adds them up
+//     once the count may have reached zero. It costs a few kilobytes per count object, so it is opt-in.
+
+// (*) Everything above is written against one LibraryObject. DetachedHandle.hpp applies the idiom to any type, with the counting policy
+//     and the allocator as template parameters.
+
+// Structure:
+
+
+class LibraryObject {
+
+  template <typename> friend class BasicRepresentation;
+
+  template <typename> friend class BasicWeakRepresentation;
+
+private:
+
+  LibraryObject (void) {
+  }
+
+  ~LibraryObject (void) noexcept {
+  }
+
+  void Behaviour (void) const {
+
+    Output () << "Behaviour executed from an unmodifiable Library Object from the Representation class.\n";
+  }
+};
+
+
+
+template <typename CountingPolicy>
+class BasicRepresentation {
+
+  template <typename> friend class BasicWeakRepresentation;
+
+public:
+
+  BasicRepresentation (void)
+
+      : implementation (new LibraryObject ())
+
+      , reference_count (new ReferenceCount {TrackedCount (1), 1, 1, this->implementation, &BasicRepresentation::DestroySeparateAllocation, &BasicRepresentation::FreeSeparateAllocation}) {
+
+    CLEANCODE_COUNT_ALLOCATION ("DetachedCountedBody", "BasicRepresentation ()", sizeof (LibraryObject));
+
+    CLEANCODE_COUNT_ALLOCATION ("DetachedCountedBody", "BasicRepresentation ()", sizeof (ReferenceCount));
+
+    this->BindReferenceCount ();
+  }
+
+  BasicRepresentation (const BasicRepresentation& another_representation) {
+
+    this->implementation  = another_representation.implementation;
+
+    this->reference_count = another_representation.reference_count;
+
+    CLEANCODE_COUNT_EVENT ("DetachedCountedBody", copy);
+
+    this->IncrementReferenceCount ();
+  }
+
+  // Moving hands the body over without touching the count; the moved-from representation is left empty.
+  BasicRepresentation (BasicRepresentation&& another_representation) noexcept
+
+      : implementation (another_representation.implementation)
+
+      , reference_count (another_representation.reference_count) {
+
+    CLEANCODE_COUNT_EVENT ("DetachedCountedBody", move);
+
+    another_representation.implementation = nullptr;
+
+    another_representation.reference_count = nullptr;
+  }
+
+  ~BasicRepresentation (void) noexcept {
+
+    this->DecrementReferenceCount ();
+  }
+
+  // Creates the library object and its reference count in a single allocation.
+  static BasicRepresentation CreateSingleAllocation (void) {
+
+    SharedBlock* shared_block = new SharedBlock ();
+
+    CLEANCODE_COUNT_ALLOCATION ("DetachedCountedBody", "BasicRepresentation::CreateSingleAllocation", sizeof (SharedBlock));
+
+    BasicRepresentation representation (shared_block->library_object, shared_block);
+
+    representation.BindReferenceCount ();
+
+    return representation;
+  }
+
+  // False for a moved-from representation, or one handed out by a weak representation whose library object was already gone.
+  explicit operator bool (void) const noexcept {
+
+    return this->implementation != nullptr;
+  }
+
+  // Assigning a representation that already shares the library object (itself included) touches no count at all. Otherwise the new
+  // count is incremented and the representation switched over to it before the old one is decremented, so that decrement can never
+  // destroy the library object being assigned, and nothing that can fail runs before the representation has changed.
+  BasicRepresentation& operator= (const BasicRepresentation& another_representation) {
+
+    CLEANCODE_COUNT_ASSIGNMENT ("DetachedCountedBody", this->reference_count == another_representation.reference_count);
+
+    if (this->reference_count == another_representation.reference_count) {
+      return *this;
+    }
+
+    another_representation.IncrementReferenceCount ();
+
+    ReferenceCount* previous_reference_count = this->reference_count;
+
+    this->implementation = another_representation.implementation;
+
+    this->reference_count = another_representation.reference_count;
+
+    ReleaseReference (previous_reference_count);
+
+    return *this;
+  }
+
+  BasicRepresentation& operator= (BasicRepresentation&& another_representation) noexcept {
+
+    CLEANCODE_COUNT_EVENT ("DetachedCountedBody", move_assignment);
+
+    if (this == &another_representation) {
+      return *this;
+    }
+
+    ReferenceCount* previous_reference_count = this->reference_count;
+
+    this->implementation = another_representation.implementation;
+
+    this->reference_count = another_representation.reference_count;
+
+    another_representation.implementation = nullptr;
+
+    another_representation.reference_count = nullptr;
+
+    ReleaseReference (previous_reference_count);
+
+    return *this;
+  }
+
+  // How many representations share the library object, as this thread sees it (see Sample in Counting.hpp); 0 for an empty
+  // representation.
+  int64_t UseCount (void) const noexcept {
+
+    if (this->reference_count == nullptr) {
+      return 0;
+    }
+
+    return CountingPolicy::Sample (this->reference_count->count);
+  }
+
+  bool SharesLibraryObjectWith (const BasicRepresentation& another_representation) const noexcept {
+
+    return this->reference_count == another_representation.reference_count;
+  }
+
+  void ExecuteBehaviour (void) {
+
+    this->implementation->Behaviour ();
+
+    Output () << "\tRepresentation Addresss: " << this
+
+        << " || Reference Counter Address: " << this->reference_count
+
+        << " || Library Object Implementation Address: " << this->implementation
+
+        << '\n';
+  }
+
+
+private:
+
+  struct ReferenceCount : TrackedCount {
+
+    typename CountingPolicy::Counter count;
+
+    // Weak representations, plus one on behalf of all the representations for as long as there are any.
+    typename CountingPolicy::WeakCounting::Counter weak_count;
+
+    LibraryObject* library_object;
+
+    // Destroys the library object once the last representation is gone, in whichever layout it was allocated.
+    void (*destroy) (ReferenceCount* reference_count);
+
+    // Frees this count (and whatever was allocated along with it) once the last weak representation is gone as well.
+    void (*deallocate) (ReferenceCount* reference_count);
+  };
+
+  // The library object is constructed into the block's storage and destroyed before the block itself, while weak representations
+  // can still look at the count.
+  struct SharedBlock : ReferenceCount {
+
+    SharedBlock (void)
+
+        : ReferenceCount {TrackedCount (1), 1, 1, nullptr, &BasicRepresentation::DestroySharedAllocation, &BasicRepresentation::FreeSharedAllocation} {
+
+      this->library_object = ::new (static_cast<void*> (this->storage)) LibraryObject ();
+    }
+
+    alignas (LibraryObject) unsigned char storage [sizeof (LibraryObject)];
+  };
+
+  // Adopts a library object whose count was already incremented on this representation's behalf.
+  BasicRepresentation (LibraryObject* implementation, ReferenceCount* reference_count) noexcept
+
+      : implementation (implementation)
+
+      , reference_count (reference_count) {
+  }
+
+  LibraryObject* implementation;
+
+  ReferenceCount* reference_count;
+
+  // Tells both counts how they are released, for counting policies that may find out about the last release late.
+  void BindReferenceCount (void) noexcept {
+
+    CountingPolicy::Bind (this->reference_count->count, this->reference_count, &BasicRepresentation::ReleaseLibraryObject);
+
+    CountingPolicy::WeakCounting::Bind (this->reference_count->weak_count, this->reference_count, &BasicRepresentation::ReleaseReferenceCount);
+  }
+
+  void DecrementReferenceCount  (void) {
+
+    ReleaseReference (this->reference_count);
+
+    this->implementation = nullptr;
+
+    this->reference_count = nullptr;
+  }
+
+  // Lets go of one reference, releasing the library object if that was the last one.
+  static void ReleaseReference (ReferenceCount* reference_count) {
+
+    if (reference_count == nullptr) {
+      return;
+    }
+
+    CLEANCODE_COUNT_DECREMENT ("DetachedCountedBody");
+
+    if (!CountingPolicy::Decrement (reference_count->count)) {
+      return;
+    }
+
+    ReleaseLibraryObject (reference_count);
+  }
+
+  void IncrementReferenceCount (void) const noexcept {
+
+    if (this->reference_count == nullptr) {
+      return;
+    }
+
+    CountingPolicy::Increment (this->reference_count->count);
+
+    CLEANCODE_COUNT_INCREMENT ("DetachedCountedBody", *this->reference_count, CountingPolicy::Sample (this->reference_count->count));
+  }
+
+  static void ReleaseLibraryObject (void* released_count) {
+
+    ReferenceCount* reference_count = static_cast<ReferenceCount*> (released_count);
+
+    CLEANCODE_COUNT_RELEASE ("DetachedCountedBody", *reference_count);
+
+    reference_count->destroy (reference_count);
+
+    ReleaseWeakReference (reference_count);
+  }
+
+  static void ReleaseWeakReference (ReferenceCount* reference_count) {
+
+    if (!CountingPolicy::WeakCounting::Decrement (reference_count->weak_count)) {
+      return;
+    }
+
+    reference_count->deallocate (reference_count);
+  }
+
+  static void ReleaseReferenceCount (void* released_count) {
+
+    ReferenceCount* reference_count = static_cast<ReferenceCount*> (released_count);
+
+    reference_count->deallocate (reference_count);
+  }
+
+  static void DestroySeparateAllocation (ReferenceCount* reference_count) {
+
+    CLEANCODE_COUNT_FREE ("DetachedCountedBody", "BasicRepresentation::DestroySeparateAllocation", sizeof (LibraryObject));
+
+    delete reference_count->library_object;
+  }
+
+  static void FreeSeparateAllocation (ReferenceCount* reference_count) {
+
+    CLEANCODE_COUNT_FREE ("DetachedCountedBody", "BasicRepresentation::FreeSeparateAllocation", sizeof (ReferenceCount));
+
+    delete reference_count;
+  }
+
+  static void DestroySharedAllocation (ReferenceCount* reference_count) {
+
+    reference_count->library_object->~LibraryObject ();
+  }
+
+  static void FreeSharedAllocation (ReferenceCount* reference_count) {
+
+    CLEANCODE_COUNT_FREE ("DetachedCountedBody", "BasicRepresentation::FreeSharedAllocation", sizeof (SharedBlock));
+
+    delete static_cast<SharedBlock*> (reference_count);
+  }
+};
+
+
+// Refers to the library object of a representation without keeping it alive.
+template <typename CountingPolicy>
+class BasicWeakRepresentation {
+
+public:
+
+  BasicWeakRepresentation (const BasicRepresentation<CountingPolicy>& representation)
+
+      : implementation (representation.implementation)
+
+      , reference_count (representation.reference_count) {
+
+    this->IncrementWeakCount ();
+  }
+
+  BasicWeakRepresentation (const BasicWeakRepresentation& another_weak_representation)
+
+      : implementation (another_weak_representation.implementation)
+
+      , reference_count (another_weak_representation.reference_count) {
+
+    this->IncrementWeakCount ();
+  }
+
+  BasicWeakRepresentation (BasicWeakRepresentation&& another_weak_representation) noexcept
+
+      : implementation (another_weak_representation.implementation)
+
+      , reference_count (another_weak_representation.reference_count) {
+
+    another_weak_representation.implementation = nullptr;
+
+    another_weak_representation.reference_count = nullptr;
+  }
+
+  ~BasicWeakRepresentation (void) noexcept {
+
+    this->DecrementWeakCount ();
+  }
+
+  // The new count is referenced before the old one is released, which also keeps self-assignment safe.
+  BasicWeakRepresentation& operator= (const BasicWeakRepresentation& another_weak_representation) {
+
+    ReferenceCount* previous_reference_count = this->reference_count;
+
+    this->implementation = another_weak_representation.implementation;
+
+    this->reference_count = another_weak_representation.reference_count;
+
+    this->IncrementWeakCount ();
+
+    if (previous_reference_count != nullptr) {
+      Representation::ReleaseWeakReference (previous_reference_count);
+    }
+
+    return *this;
+  }
+
+  BasicWeakRepresentation& operator= (BasicWeakRepresentation&& another_weak_representation) noexcept {
+
+    if (this == &another_weak_representation) {
+      return *this;
+    }
+
+    this->DecrementWeakCount ();
+
+    this->implementation = another_weak_representation.implementation;
+
+    this->reference_count = another_weak_representation.reference_count;
+
+    another_weak_representation.implementation = nullptr;
+
+    another_weak_representation.reference_count = nullptr;
+
+    return *this;
+  }
+
+  // A representation of the library object if it is still alive, an empty one otherwise.
+  BasicRepresentation<CountingPolicy> Lock (void) const {
+
+    if (this->reference_count == nullptr || !CountingPolicy::IncrementIfNonZero (this->reference_count->count)) {
+      return Representation (nullptr, nullptr);
+    }
+
+    CLEANCODE_COUNT_INCREMENT ("DetachedCountedBody", *this->reference_count, CountingPolicy::Sample (this->reference_count->count));
+
+    return Representation (this->implementation, this->reference_count);
+  }
+
+private:
+
+  using Representation = BasicRepresentation<CountingPolicy>;
+
+  using ReferenceCount = typename Representation::ReferenceCount;
+
+  void DecrementWeakCount (void) {
+
+    if (this->reference_count == nullptr) {
+      return;
+    }
+
+    Representation::ReleaseWeakReference (this->reference_count);
+
+    this->implementation = nullptr;
+
+    this->reference_count = nullptr;
+  }
+
+  void IncrementWeakCount (void) {
+
+    if (this->reference_count == nullptr) {
+      return;
+    }
+
+    CountingPolicy::WeakCounting::Increment (this->reference_count->weak_count);
+  }
+
+  LibraryObject* implementation;
+
+  ReferenceCount* reference_count;
+};
+
+
+// Representations whose copies all stay on one thread.
+using Representation = BasicRepresentation<SingleThreadedCounting>;
+
+// Representations that can be copied and destroyed from any thread.
+using AtomicRepresentation = BasicRepresentation<AtomicCounting>;
+
+// Representations that are cheapest to copy and destroy on the thread that created their library object, but can be used from any thread.
+using BiasedRepresentation = BasicRepresentation<BiasedCounting>;
+
+// Representations of a library object that many threads copy and destroy at the same time.
+using ShardedRepresentation = BasicRepresentation<ShardedCounting>;
+
+using WeakRepresentation = BasicWeakRepresentation<SingleThreadedCounting>;
+
+using AtomicWeakRepresentation = BasicWeakRepresentation<AtomicCounting>;
+
+using BiasedWeakRepresentation = BasicWeakRepresentation<BiasedCounting>;
+
+using ShardedWeakRepresentation = BasicWeakRepresentation<ShardedCounting>;
+
+#endif
@@ -0,0 +1,396 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "DetachedCountedBody.hpp"
+#include "../Common/LifecycleBenchmarks.hpp"
+
+// Detached Counted Body Idiom Benchmarks.
+
+// Build: g++ -std=c++17 -O2 DetachedCountedBodyBenchmark.cpp -lbenchmark -lpthread
+
+// Compares the original two allocation layout (Representation ()) against the single allocation factory
+// (Representation::CreateSingleAllocation ()).
+
+// (*) The global operator new is replaced below so every benchmark can report heap allocations per iteration.
+
+// (*) The cold copy benchmarks spread far more bodies than fit in the core's private caches and copy them in random order, so nearly every count update
+//     misses. Where the benchmark library is built with libpfm, add --benchmark_perf_counters=CACHE-MISSES to count the misses directly.
+
+// (*) The owner-dominated and shared benchmarks copy and destroy handles from 1 to 8 threads, atomic against biased counting: each thread
+//     on a library object of its own (so biased counting never needs an atomic update), or all of them on one shared library object
+//     (so only the thread that created it stays off the shared count).
+
+// (*) The contended benchmarks copy and destroy handles to one shared library object from 64 threads at once, a single atomic count
+//     against sharded counting, where every thread counts in a cache line of its own. The hand-off variant releases every reference on
+//     another thread than the one that took it, as a producer handing work to a consumer would.
+
+// (*) The same-body assignment benchmarks assign one shared handle, from 1 to 8 threads, to a copy of it each thread keeps. Both already
+//     share the library object, so whatever an iteration costs is wasted on the assignment.
+
+// (*) The vector push benchmarks push millions of copies of one handle into a growing vector, with the move operations and through a
+//     copy-only wrapper (how the representation behaved before it had them), so the difference is the cost of relocating by copy.
+
+// (*) Lifecycle: construction, copying, assignment, destruction and dispatch with each counting policy but sharded counting (whose count
+//     objects are too large for a cold batch), on warm and cold batches from 1 to 8 threads (see LifecycleBenchmarks.hpp).
+
+
+// Counted from every benchmark thread.
+static std::atomic<int64_t> allocation_count (0);
+
+// The replacements are kept out of line: once inlined, GCC sees malloc paired with operator delete (or operator new paired with free)
+// and warns about mismatched allocation functions.
+__attribute__ ((noinline)) void* operator new (std::size_t size) {
+
+  allocation_count.fetch_add (1, std::memory_order_relaxed);
+
+  if (void* memory = std::malloc (size)) {
+
+    return memory;
+  }
+
+  throw std::bad_alloc ();
+}
+
+__attribute__ ((noinline)) void operator delete (void* memory) noexcept {
+
+  std::free (memory);
+}
+
+__attribute__ ((noinline)) void operator delete (void* memory, std::size_t) noexcept {
+
+  std::free (memory);
+}
+
+
+template <typename Factory>
+static void CreateDestroy (benchmark::State& state, Factory create) {
+
+  int64_t allocations_before = allocation_count;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      Representation representation_object = create ();
+
+      benchmark::DoNotOptimize (representation_object);
+    }
+  }
+
+  state.counters ["heap_allocations"] = benchmark::Counter (allocation_count - allocations_before, benchmark::Counter::kAvgIterations);
+
+  ReportAllocations (state, state.iterations ());
+}
+
+static void BM_CreateDestroy_TwoAllocations (benchmark::State& state) {
+
+  CreateDestroy (state, [] () { return Representation (); });
+}
+
+static void BM_CreateDestroy_SingleAllocation (benchmark::State& state) {
+
+  CreateDestroy (state, [] () { return Representation::CreateSingleAllocation (); });
+}
+
+BENCHMARK (BM_CreateDestroy_TwoAllocations);
+
+BENCHMARK (BM_CreateDestroy_SingleAllocation);
+
+
+template <typename Factory>
+static void ColdCopy (benchmark::State& state, Factory create) {
+
+  std::vector<Representation> representation_objects;
+
+  representation_objects.reserve (state.range (0));
+
+  for (int64_t index = 0; index < state.range (0); ++index) {
+
+    representation_objects.push_back (create ());
+  }
+
+  std::vector<std::size_t> visiting_order (representation_objects.size ());
+
+  std::iota (visiting_order.begin (), visiting_order.end (), 0);
+
+  std::shuffle (visiting_order.begin (), visiting_order.end (), std::mt19937_64 (42));
+
+  std::size_t next = 0;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      Representation copied_representation_object (representation_objects [visiting_order [next]]);
+
+      benchmark::DoNotOptimize (copied_representation_object);
+
+      next = (next + 1 == visiting_order.size ()) ? 0 : next + 1;
+    }
+  }
+
+  ReportAllocations (state, state.iterations ());
+}
+
+static void BM_ColdCopy_TwoAllocations (benchmark::State& state) {
+
+  ColdCopy (state, [] () { return Representation (); });
+}
+
+static void BM_ColdCopy_SingleAllocation (benchmark::State& state) {
+
+  ColdCopy (state, [] () { return Representation::CreateSingleAllocation (); });
+}
+
+BENCHMARK (BM_ColdCopy_TwoAllocations)->Arg (1 << 10)->Arg (1 << 22);
+
+BENCHMARK (BM_ColdCopy_SingleAllocation)->Arg (1 << 10)->Arg (1 << 22);
+
+
+template <typename Handle>
+static void OwnerDominated (benchmark::State& state) {
+
+  Handle owned_representation_object;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      Handle copied_representation_object (owned_representation_object);
+
+      benchmark::DoNotOptimize (copied_representation_object);
+    }
+  }
+
+  ReportAllocations (state, state.iterations ());
+}
+
+BENCHMARK_TEMPLATE (OwnerDominated, AtomicRepresentation)->ThreadRange (1, 8)->UseRealTime ();
+
+BENCHMARK_TEMPLATE (OwnerDominated, BiasedRepresentation)->ThreadRange (1, 8)->UseRealTime ();
+
+
+template <typename Handle>
+static void Shared (benchmark::State& state) {
+
+  static Handle shared_representation_object;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      Handle copied_representation_object (shared_representation_object);
+
+      benchmark::DoNotOptimize (copied_representation_object);
+    }
+  }
+
+  ReportAllocations (state, state.iterations ());
+}
+
+BENCHMARK_TEMPLATE (Shared, AtomicRepresentation)->ThreadRange (1, 8)->UseRealTime ();
+
+BENCHMARK_TEMPLATE (Shared, BiasedRepresentation)->ThreadRange (1, 8)->UseRealTime ();
+
+BENCHMARK_TEMPLATE (Shared, ShardedRepresentation)->ThreadRange (1, 8)->UseRealTime ();
+
+
+template <typename Handle>
+static void Contended (benchmark::State& state) {
+
+  static Handle contended_representation_object;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      Handle copied_representation_object (contended_representation_object);
+
+      benchmark::DoNotOptimize (copied_representation_object);
+    }
+  }
+
+  ReportAllocations (state, state.iterations ());
+}
+
+BENCHMARK_TEMPLATE (Contended, AtomicRepresentation)->Threads (64)->UseRealTime ();
+
+BENCHMARK_TEMPLATE (Contended, ShardedRepresentation)->Threads (64)->UseRealTime ();
+
+
+// Threads pair up and trade boxes through a slot the two share, so every reference is taken on one thread and released on the other:
+// each iteration empties the box the partner filled, fills it again and hands it back. Boxes live as long as the program, since a
+// thread may still hold its partner's box when the benchmark ends.
+template <typename Handle>
+static void ContendedHandOff (benchmark::State& state) {
+
+  constexpr int maximum_thread_count = 64;
+
+  struct alignas (64) HandOffSlot {
+
+    std::atomic<Handle*> box;
+  };
+
+  static Handle contended_representation_object;
+
+  static Handle boxes [maximum_thread_count + maximum_thread_count / 2];
+
+  static HandOffSlot* slots = [] (void) {
+
+    static HandOffSlot slots [maximum_thread_count / 2];
+
+    for (int slot_index = 0; slot_index < maximum_thread_count / 2; ++slot_index) {
+
+      slots [slot_index].box.store (&boxes [maximum_thread_count + slot_index], std::memory_order_relaxed);
+    }
+
+    return slots;
+  } ();
+
+  Handle* box = &boxes [state.thread_index ()];
+
+  std::atomic<Handle*>& slot = slots [state.thread_index () / 2].box;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      {
+        Handle released_representation_object (std::move (*box));
+      }
+
+      *box = contended_representation_object;
+
+      box = slot.exchange (box, std::memory_order_acq_rel);
+    }
+  }
+
+  ReportAllocations (state, state.iterations ());
+}
+
+BENCHMARK_TEMPLATE (ContendedHandOff, AtomicRepresentation)->Threads (64)->UseRealTime ();
+
+BENCHMARK_TEMPLATE (ContendedHandOff, ShardedRepresentation)->Threads (64)->UseRealTime ();
+
+
+template <typename Handle>
+static void SameBodyAssignment (benchmark::State& state) {
+
+  static Handle shared_representation_object;
+
+  Handle assigned_representation_object (shared_representation_object);
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      assigned_representation_object = shared_representation_object;
+
+      benchmark::DoNotOptimize (assigned_representation_object);
+    }
+  }
+
+  ReportAllocations (state, state.iterations ());
+}
+
+BENCHMARK_TEMPLATE (SameBodyAssignment, Representation);
+
+BENCHMARK_TEMPLATE (SameBodyAssignment, AtomicRepresentation)->ThreadRange (1, 8)->UseRealTime ();
+
+BENCHMARK_TEMPLATE (SameBodyAssignment, ShardedRepresentation)->ThreadRange (1, 8)->UseRealTime ();
+
+
+// Declaring the copy operations suppresses the implicit move operations, so the vector has to copy.
+class CopyOnlyRepresentation {
+
+public:
+
+  CopyOnlyRepresentation (void) = default;
+
+  CopyOnlyRepresentation (const CopyOnlyRepresentation&) = default;
+
+  CopyOnlyRepresentation& operator= (const CopyOnlyRepresentation&) = default;
+
+  Representation representation;
+};
+
+template <typename Handle>
+static void PushBack (benchmark::State& state) {
+
+  Handle prototype;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      std::vector<Handle> handles;
+
+      for (int64_t index = 0; index < state.range (0); ++index) {
+
+        handles.push_back (prototype);
+      }
+
+      benchmark::DoNotOptimize (handles.data ());
+    }
+  }
+
+  state.SetItemsProcessed (state.iterations () * state.range (0));
+
+  ReportAllocations (state, state.iterations () * state.range (0));
+}
+
+BENCHMARK_TEMPLATE (PushBack, CopyOnlyRepresentation)->Arg (1 << 22)->Unit (benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE (PushBack, Representation)->Arg (1 << 22)->Unit (benchmark::kMillisecond);
+
+
+// Lifecycle suite (LifecycleBenchmarks.hpp).
+
+BENCHMARK_TEMPLATE (Construction, Representation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Construction, AtomicRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Construction, BiasedRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Copying, Representation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Copying, AtomicRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Copying, BiasedRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Assignment, Representation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Assignment, AtomicRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Assignment, BiasedRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Destruction, Representation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Destruction, AtomicRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Destruction, BiasedRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Dispatch, Representation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Dispatch, AtomicRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Dispatch, BiasedRepresentation)->Apply (LifecycleRuns);
+
+
+BENCHMARK_MAIN ();
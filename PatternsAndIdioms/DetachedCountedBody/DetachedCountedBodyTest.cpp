@@ -0,0 +1,419 @@
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "DetachedCountedBody.hpp"
+#include "DetachedHandle.hpp"
+
+
+// Assignment has to leave every count where copying would have: untouched when the library object is already shared, one more on the
+// assigned one and one less on the released one otherwise.
+
+// Self-assignment of the sole representation of a library object.
+template <typename RepresentationType>
+void CheckSelfAssignment (void) {
+
+  RepresentationType self_representation;
+
+  RepresentationType& same_representation = self_representation;
+
+  self_representation = same_representation;
+
+  assert (self_representation.UseCount () == 1 && self_representation.SharesLibraryObjectWith (same_representation));
+}
+
+// Assignment between representations that already share a library object.
+template <typename RepresentationType>
+void CheckSameBodyAssignment (void) {
+
+  RepresentationType first_representation;
+
+  RepresentationType second_representation (first_representation);
+
+  assert (first_representation.UseCount () == 2);
+
+  second_representation = first_representation;
+
+  assert (first_representation.UseCount () == 2 && second_representation.SharesLibraryObjectWith (first_representation));
+}
+
+// Assignment onto another library object releases it, in either layout.
+template <typename RepresentationType>
+void CheckOtherBodyAssignment (void) {
+
+  RepresentationType first_representation;
+
+  RepresentationType other_representation = RepresentationType::CreateSingleAllocation ();
+
+  RepresentationType other_copy (other_representation);
+
+  other_representation = first_representation;
+
+  assert (first_representation.UseCount () == 2 && other_representation.SharesLibraryObjectWith (first_representation));
+
+  assert (other_copy.UseCount () == 1 && !other_copy.SharesLibraryObjectWith (first_representation));
+}
+
+// Chained assignment ends with every representation on the rightmost library object.
+template <typename RepresentationType>
+void CheckChainedAssignment (void) {
+
+  RepresentationType chain_first;
+
+  RepresentationType chain_second = RepresentationType::CreateSingleAllocation ();
+
+  RepresentationType chain_third;
+
+  chain_first = chain_second = chain_third;
+
+  assert (chain_third.UseCount () == 3);
+
+  assert (chain_first.SharesLibraryObjectWith (chain_third) && chain_second.SharesLibraryObjectWith (chain_third));
+
+  RepresentationType other_representation;
+
+  chain_first = chain_second = other_representation;
+
+  assert (other_representation.UseCount () == 3 && chain_third.UseCount () == 1);
+
+  assert (chain_first.SharesLibraryObjectWith (other_representation) && chain_second.SharesLibraryObjectWith (other_representation));
+}
+
+template <typename RepresentationType>
+void CheckAssignment (void) {
+
+  CheckSelfAssignment<RepresentationType> ();
+
+  CheckSameBodyAssignment<RepresentationType> ();
+
+  CheckOtherBodyAssignment<RepresentationType> ();
+
+  CheckChainedAssignment<RepresentationType> ();
+}
+
+// Threads assign a shared representation and their own back and forth; once they are done, the shared library object has to be
+// counted exactly once per representation left holding it.
+template <typename RepresentationType>
+void CheckCrossThreadAssignment (void) {
+
+  const int thread_count = 4;
+
+  RepresentationType shared_representation;
+
+  std::vector<RepresentationType> thread_representations (thread_count);
+
+  std::vector<std::thread> threads;
+
+  for (int thread_index = 0; thread_index < thread_count; ++thread_index) {
+
+    threads.emplace_back ([&shared_representation, &thread_representation = thread_representations [thread_index]] (void) {
+
+      RepresentationType own_representation;
+
+      for (int round = 0; round < 1000; ++round) {
+
+        thread_representation = shared_representation;
+
+        thread_representation = own_representation;
+      }
+
+      thread_representation = shared_representation;
+
+      assert (own_representation.UseCount () == 1);
+    });
+  }
+
+  for (std::thread& thread : threads) {
+
+    thread.join ();
+  }
+
+  assert (shared_representation.UseCount () == 1 + thread_count);
+
+  for (const RepresentationType& thread_representation : thread_representations) {
+
+    assert (thread_representation.SharesLibraryObjectWith (shared_representation));
+  }
+
+  thread_representations.clear ();
+
+  assert (shared_representation.UseCount () == 1);
+}
+
+
+// Biased counting, where the thread that created a body counts its own references apart. The weak representation tells whether the
+// count was found at zero: it can be locked until then, and not after.
+
+// The owner releases last, after another thread copied the body and let go of its copy.
+template <typename RepresentationType, typename WeakRepresentationType>
+void CheckBiasedOwnerReleasesLast (void) {
+
+  RepresentationType owning_representation;
+
+  WeakRepresentationType weak_representation (owning_representation);
+
+  std::thread ([&owning_representation] (void) {
+
+    RepresentationType copied_representation (owning_representation);
+
+    assert (copied_representation);
+  }).join ();
+
+  assert (weak_representation.Lock ());
+
+  {
+    RepresentationType released_representation (std::move (owning_representation));
+  }
+
+  assert (!weak_representation.Lock ());
+}
+
+// Another thread releases last, while the owner is still alive. The counter waits in the owner's queue until the owner merges it; until
+// then a weak representation can still be locked, and the lock keeps the body alive. The owner's next count update merges the counter,
+// finds it at zero and reclaims the body.
+template <typename RepresentationType, typename WeakRepresentationType>
+void CheckBiasedNonOwnerReleasesLast (void) {
+
+  RepresentationType owning_representation;
+
+  WeakRepresentationType weak_representation (owning_representation);
+
+  RepresentationType handed_representation (owning_representation);
+
+  {
+    RepresentationType released_representation (std::move (owning_representation));
+  }
+
+  std::thread ([&handed_representation, &weak_representation] (void) {
+
+    {
+      RepresentationType released_representation (std::move (handed_representation));
+    }
+
+    RepresentationType locked_representation = weak_representation.Lock ();
+
+    assert (locked_representation);
+
+    RepresentationType copied_representation (locked_representation);
+
+    assert (copied_representation);
+  }).join ();
+
+  assert (!weak_representation.Lock ());
+}
+
+// The owner exits while another thread still holds a reference it counted. The release that follows merges the counter itself.
+template <typename RepresentationType, typename WeakRepresentationType>
+void CheckBiasedOwnerExitsFirst (void) {
+
+  std::vector<RepresentationType> handed_representations;
+
+  std::vector<WeakRepresentationType> weak_representations;
+
+  std::thread ([&handed_representations, &weak_representations] (void) {
+
+    RepresentationType owning_representation;
+
+    weak_representations.push_back (WeakRepresentationType (owning_representation));
+
+    handed_representations.push_back (owning_representation);
+  }).join ();
+
+  assert (weak_representations.front ().Lock ());
+
+  handed_representations.clear ();
+
+  assert (!weak_representations.front ().Lock ());
+}
+
+
+// Library objects whose count was found at zero.
+static std::atomic<int64_t> released_library_object_count (0);
+
+// Sharded counting that counts released library objects.
+class ReleaseCountingShardedCounting : public ShardedCounting {
+
+public:
+
+  static bool Decrement (Counter& counter) noexcept {
+
+    if (!ShardedCounting::Decrement (counter)) {
+
+      return false;
+    }
+
+    released_library_object_count.fetch_add (1, std::memory_order_relaxed);
+
+    return true;
+  }
+};
+
+using ReleaseCountingRepresentation = BasicRepresentation<ReleaseCountingShardedCounting>;
+
+using ReleaseCountingWeakRepresentation = BasicWeakRepresentation<ReleaseCountingShardedCounting>;
+
+// References taken on one thread and released on another, so that releases find their own slot empty and go through the central count,
+// with the last one released away from the thread that created the library object. The count reaches zero exactly once, at the end, and
+// a folded count can't be locked anymore, from any thread.
+void CheckShardedCrossThreadRelease (void) {
+
+  const int64_t initial_released_count = released_library_object_count.load ();
+
+  ReleaseCountingRepresentation owning_representation;
+
+  ReleaseCountingWeakRepresentation weak_representation (owning_representation);
+
+  std::vector<ReleaseCountingRepresentation> copied_representations;
+
+  std::thread ([&owning_representation, &copied_representations] (void) {
+
+    for (int copy = 0; copy < 16; ++copy) {
+
+      copied_representations.push_back (owning_representation);
+    }
+  }).join ();
+
+  std::thread ([&copied_representations] (void) {
+
+    copied_representations.clear ();
+  }).join ();
+
+  assert (released_library_object_count.load () == initial_released_count && weak_representation.Lock ());
+
+  std::thread ([&owning_representation, &weak_representation] (void) {
+
+    {
+      ReleaseCountingRepresentation released_representation (std::move (owning_representation));
+    }
+
+    assert (!weak_representation.Lock ());
+  }).join ();
+
+  assert (released_library_object_count.load () == initial_released_count + 1 && !weak_representation.Lock ());
+}
+
+// The last representation is released on one thread while others lock the weak representation and copy what they locked. A lock
+// that lands while the slots are being folded either still finds its slot open, and is added up by the fold, or finds the count folded
+// and goes through the central count; either way whatever was locked stays alive until it's released, and the count reaches zero
+// exactly once, after which nothing locks it anymore.
+void CheckShardedLockDuringFold (void) {
+
+  for (int round = 0; round < 200; ++round) {
+
+    const int64_t initial_released_count = released_library_object_count.load ();
+
+    ReleaseCountingRepresentation owning_representation;
+
+    ReleaseCountingWeakRepresentation weak_representation (owning_representation);
+
+    std::atomic<bool> released (false);
+
+    std::vector<std::thread> locking_threads;
+
+    for (int thread = 0; thread < 3; ++thread) {
+
+      locking_threads.emplace_back ([&weak_representation, &released, initial_released_count] (void) {
+
+        while (!released.load ()) {
+
+          ReleaseCountingRepresentation locked_representation = weak_representation.Lock ();
+
+          if (!locked_representation) {
+
+            continue;
+          }
+
+          ReleaseCountingRepresentation copied_representation (locked_representation);
+
+          assert (released_library_object_count.load () == initial_released_count);
+        }
+      });
+    }
+
+    std::thread ([&owning_representation, &released] (void) {
+
+      {
+        ReleaseCountingRepresentation released_representation (std::move (owning_representation));
+      }
+
+      released.store (true);
+    }).join ();
+
+    for (std::thread& locking_thread : locking_threads) {
+
+      locking_thread.join ();
+    }
+
+    assert (released_library_object_count.load () == initial_released_count + 1 && !weak_representation.Lock ());
+  }
+}
+
+
+int main (void) {
+
+  // Representations in either layout can be copied, moved and watched by a weak representation until the last one goes.
+
+  Representation first_representation;
+
+  Representation copied_representation (first_representation);
+
+  Representation moved_representation (std::move (copied_representation));
+
+  assert (!copied_representation && moved_representation);
+
+  WeakRepresentation weak_representation (first_representation);
+
+  first_representation = Representation::CreateSingleAllocation ();
+
+  assert (weak_representation.Lock ());
+
+  moved_representation = first_representation;
+
+  assert (!weak_representation.Lock ());
+
+  // Handles to any value share the one value, however it was allocated.
+
+  DetachedHandle<std::string> first_handle = DetachedHandle<std::string>::Create ("value");
+
+  DetachedHandle<std::string> second_handle (first_handle);
+
+  assert (second_handle.Get () == first_handle.Get () && *second_handle == "value");
+
+  DetachedHandle<std::string> adopting_handle (new std::string ("adopted"));
+
+  second_handle = adopting_handle;
+
+  assert (second_handle.Get () == adopting_handle.Get () && *second_handle == "adopted");
+
+  DetachedHandle<std::string> moved_handle (std::move (first_handle));
+
+  assert (!first_handle && *moved_handle == "value");
+
+  // Assignment, on one thread and across threads.
+
+  CheckAssignment<Representation> ();
+
+  CheckAssignment<AtomicRepresentation> ();
+
+  CheckCrossThreadAssignment<AtomicRepresentation> ();
+
+  // Biased counting: whichever thread releases last, and whether or not the owner is still around.
+
+  CheckBiasedOwnerReleasesLast<BiasedRepresentation, BiasedWeakRepresentation> ();
+
+  CheckBiasedNonOwnerReleasesLast<BiasedRepresentation, BiasedWeakRepresentation> ();
+
+  CheckBiasedOwnerExitsFirst<BiasedRepresentation, BiasedWeakRepresentation> ();
+
+  // Sharded counting: the last release folds the slots, whichever thread it happens on and whatever locks it races with.
+
+  CheckShardedCrossThreadRelease ();
+
+  CheckShardedLockDuringFold ();
+
+  return 0;
+}
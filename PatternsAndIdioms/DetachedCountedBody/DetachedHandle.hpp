@@ -0,0 +1,348 @@
+#ifndef DETACHED_HANDLE_HPP
+#define DETACHED_HANDLE_HPP
+
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "../Common/AllocationTracking.hpp"
+#include "../Common/CountTracking.hpp"
+#include "../Common/Counting.hpp"
+
+// Detached Handle.
+
+// The Detached Counted Body Idiom for any type, rather than for the one LibraryObject of DetachedCountedBody.hpp: DetachedHandle<Value>
+// counts the references to a Value that knows nothing about them, in a count object of its own.
+
+// (*) Adopting an object that already exists (allocated with new) only allocates its count object; the last handle deletes the object.
+//     Create builds the value and its count in a single block instead, the way CreateSingleAllocation does.
+
+// (*) Count objects and blocks come out of the allocator (rebound to whatever is allocated), so handles can be pooled or arena allocated.
+//     The allocator is kept in the count object and frees it once the last handle goes.
+
+// (*) The counting policy (Counting.hpp) decides which threads may hold copies of a handle. Like the allocator it is a template
+//     parameter, so every count update is a direct call the compiler can inline into the handle.
+
+
+template <typename Value, typename CountingPolicy = SingleThreadedCounting, typename Allocator = std::allocator<Value>>
+class DetachedHandle {
+
+public:
+
+  // A handle to a default constructed value, in one block with its count.
+  DetachedHandle (void)
+
+      : DetachedHandle (Create ()) {
+  }
+
+  // Adopts an object allocated with new. If its count object can't be allocated, the object is deleted before the exception goes on.
+  explicit DetachedHandle (Value* value, const Allocator& allocator = Allocator ())
+
+      : value (value)
+
+      , reference_count (nullptr) {
+
+    try {
+
+      this->reference_count = AllocateCount<AdoptedCount> (allocator, value);
+    }
+    catch (...) {
+
+      delete value;
+
+      throw;
+    }
+
+    this->BindReferenceCount ();
+  }
+
+  // A value constructed from the arguments, in one block with its count.
+  template <typename... Arguments>
+  static DetachedHandle Create (Arguments&&... arguments) {
+
+    return CreateWithAllocator (Allocator (), std::forward<Arguments> (arguments)...);
+  }
+
+  template <typename... Arguments>
+  static DetachedHandle CreateWithAllocator (const Allocator& allocator, Arguments&&... arguments) {
+
+    SharedBlock* shared_block = AllocateCount<SharedBlock> (allocator);
+
+    try {
+
+      shared_block->value = ::new (static_cast<void*> (shared_block->storage)) Value (std::forward<Arguments> (arguments)...);
+    }
+    catch (...) {
+
+      FreeCount (shared_block);
+
+      throw;
+    }
+
+    DetachedHandle handle (shared_block->value, shared_block);
+
+    handle.BindReferenceCount ();
+
+    return handle;
+  }
+
+  DetachedHandle (const DetachedHandle& another_handle)
+
+      : value (another_handle.value)
+
+      , reference_count (another_handle.reference_count) {
+
+    CLEANCODE_COUNT_EVENT ("DetachedCountedBody", copy);
+
+    this->IncrementReferenceCount ();
+  }
+
+  DetachedHandle (DetachedHandle&& another_handle) noexcept
+
+      : value (another_handle.value)
+
+      , reference_count (another_handle.reference_count) {
+
+    CLEANCODE_COUNT_EVENT ("DetachedCountedBody", move);
+
+    another_handle.value = nullptr;
+
+    another_handle.reference_count = nullptr;
+  }
+
+  ~DetachedHandle (void) noexcept {
+
+    this->DecrementReferenceCount ();
+  }
+
+  // The new reference is taken before the old one is let go, so a handle assigned a copy of itself never frees the value on the way.
+  DetachedHandle& operator= (const DetachedHandle& another_handle) {
+
+    CLEANCODE_COUNT_ASSIGNMENT ("DetachedCountedBody", this->reference_count == another_handle.reference_count);
+
+    if (this->reference_count == another_handle.reference_count) {
+
+      return *this;
+    }
+
+    another_handle.IncrementReferenceCount ();
+
+    this->DecrementReferenceCount ();
+
+    this->value = another_handle.value;
+
+    this->reference_count = another_handle.reference_count;
+
+    return *this;
+  }
+
+  DetachedHandle& operator= (DetachedHandle&& another_handle) noexcept {
+
+    CLEANCODE_COUNT_EVENT ("DetachedCountedBody", move_assignment);
+
+    if (this == &another_handle) {
+
+      return *this;
+    }
+
+    this->DecrementReferenceCount ();
+
+    this->value = another_handle.value;
+
+    this->reference_count = another_handle.reference_count;
+
+    another_handle.value = nullptr;
+
+    another_handle.reference_count = nullptr;
+
+    return *this;
+  }
+
+  // False for a moved-from handle.
+  explicit operator bool (void) const noexcept {
+
+    return this->value != nullptr;
+  }
+
+  Value& operator* (void) const noexcept {
+
+    return *this->value;
+  }
+
+  Value* operator-> (void) const noexcept {
+
+    return this->value;
+  }
+
+  Value* Get (void) const noexcept {
+
+    return this->value;
+  }
+
+private:
+
+  struct ReferenceCount : TrackedCount {
+
+    typename CountingPolicy::Counter count;
+
+    // Destroys the value and frees this count (and whatever was allocated along with it).
+    void (*release) (ReferenceCount* reference_count);
+  };
+
+  // The count of an adopted object, allocated on its own.
+  struct AdoptedCount : ReferenceCount {
+
+    AdoptedCount (const Allocator& allocator, Value* value)
+
+        : ReferenceCount {TrackedCount (1), 1, &DetachedHandle::Release<AdoptedCount>}
+
+        , allocator (allocator)
+
+        , value (value) {
+    }
+
+    Allocator allocator;
+
+    Value* value;
+
+    void DestroyValue (void) {
+
+      delete this->value;
+    }
+  };
+
+  // The count with the value constructed into the block's storage.
+  struct SharedBlock : ReferenceCount {
+
+    explicit SharedBlock (const Allocator& allocator)
+
+        : ReferenceCount {TrackedCount (1), 1, &DetachedHandle::Release<SharedBlock>}
+
+        , allocator (allocator)
+
+        , value (nullptr) {
+    }
+
+    Allocator allocator;
+
+    Value* value;
+
+    alignas (Value) unsigned char storage [sizeof (Value)];
+
+    void DestroyValue (void) {
+
+      this->value->~Value ();
+    }
+  };
+
+  // Adopts a value whose count already holds this handle's reference.
+  DetachedHandle (Value* value, ReferenceCount* reference_count) noexcept
+
+      : value (value)
+
+      , reference_count (reference_count) {
+  }
+
+  Value* value;
+
+  ReferenceCount* reference_count;
+
+  // If the count fails to construct (its copy of the allocator may throw), its block is freed before the exception goes on.
+  template <typename Count, typename... Arguments>
+  static Count* AllocateCount (const Allocator& allocator, Arguments&&... arguments) {
+
+    using CountAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Count>;
+
+    CountAllocator count_allocator (allocator);
+
+    Count* count = std::allocator_traits<CountAllocator>::allocate (count_allocator, 1);
+
+    try {
+
+      ::new (static_cast<void*> (count)) Count (allocator, std::forward<Arguments> (arguments)...);
+    }
+    catch (...) {
+
+      std::allocator_traits<CountAllocator>::deallocate (count_allocator, count, 1);
+
+      throw;
+    }
+
+    CLEANCODE_COUNT_ALLOCATION ("DetachedCountedBody", "DetachedHandle::AllocateCount", sizeof (Count));
+
+    return count;
+  }
+
+  // The allocator is moved out of the count before the count is destroyed, and frees it afterwards.
+  template <typename Count>
+  static void FreeCount (Count* count) noexcept {
+
+    using CountAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Count>;
+
+    CountAllocator count_allocator (std::move (count->allocator));
+
+    count->~Count ();
+
+    std::allocator_traits<CountAllocator>::deallocate (count_allocator, count, 1);
+
+    CLEANCODE_COUNT_FREE ("DetachedCountedBody", "DetachedHandle::FreeCount", sizeof (Count));
+  }
+
+  template <typename Count>
+  static void Release (ReferenceCount* reference_count) {
+
+    Count* count = static_cast<Count*> (reference_count);
+
+    count->DestroyValue ();
+
+    FreeCount (count);
+  }
+
+  static void ReleaseReferenceCount (void* released_count) {
+
+    ReferenceCount* reference_count = static_cast<ReferenceCount*> (released_count);
+
+    CLEANCODE_COUNT_RELEASE ("DetachedCountedBody", *reference_count);
+
+    reference_count->release (reference_count);
+  }
+
+  // Tells the count how it is released, for counting policies that may find out about the last release late.
+  void BindReferenceCount (void) noexcept {
+
+    CountingPolicy::Bind (this->reference_count->count, this->reference_count, &DetachedHandle::ReleaseReferenceCount);
+  }
+
+  void IncrementReferenceCount (void) const noexcept {
+
+    if (this->reference_count == nullptr) {
+
+      return;
+    }
+
+    CountingPolicy::Increment (this->reference_count->count);
+
+    CLEANCODE_COUNT_INCREMENT ("DetachedCountedBody", *this->reference_count, CountingPolicy::Sample (this->reference_count->count));
+  }
+
+  void DecrementReferenceCount (void) {
+
+    if (this->reference_count == nullptr) {
+
+      return;
+    }
+
+    CLEANCODE_COUNT_DECREMENT ("DetachedCountedBody");
+
+    if (CountingPolicy::Decrement (this->reference_count->count)) {
+
+      ReleaseReferenceCount (this->reference_count);
+    }
+
+    this->value = nullptr;
+
+    this->reference_count = nullptr;
+  }
+};
+
+#endif
@@ -1,88 +1,42 @@
-#include <iostream>
 #include <string>
 
-// The Handle Body Idiom.
+#include "HandleBody.hpp"
+#include "Pimpl.hpp"
 
-// Motivation:
 
-// (1) Although access specifiers certainly helps towards the principle of encapsulation, the implementation and the representation
-//     of the object is still hard-coupled to each other. This means that a change on the implementation of the object, will require 
-//     a recompilation of the representation code (since they're written in the same spot).
-
-// (2) We take a hit on the object extensibility if we keep the implementation of the code in the same place as its representation
-//     since each representation methods are hard-coupled with the well-hidden but highly specialized implementation code.
-//     What this entails for us is that it will be unnecessarily difficult for us to change around our object implementation if
-//     something better comes up in the near future.
-
-// Solution:
-
-// (*) Create two objects: one for implementation and one for representation. 
-
-// (*) The representation will be fully transparent with each necessary method being accessible to the public. 
-
-// (*) As for the implementation, all methods will be private. 
-//     This requires the implementation object to declare the representation object as a 'friend.' 
-
-// (*) Any attempt to access a representation method is internally just a delegation to an implementation method.
-
-// Structure:
+int main (int arg_count, char* arg_vector []) {
 
+  // Demonstration of the Handle Body Idiom:
 
-class Implementation {
-  
-  friend class Representation;
+  Representation representation_object;
 
-private:
-  
-  Implementation (void) {
-  }
+  representation_object.ExecuteBehaviour ();
 
-  ~Implementation (void) noexcept {
-  }
+  // Same representation, with the implementation allocated from a slab pool:
 
-  void Behaviour (void) const {
-    
-    std::cout << "Behaviour called from the Implementation class through the Representation class.\n";
-  }
+  PooledRepresentation pooled_representation_object;
 
-};
+  pooled_representation_object.ExecuteBehaviour ();
 
+  // ...and from the calling thread's cache in front of the pool:
 
-class Representation {
-  
-public:
-  
-  Representation (void) 
-      
-      : implementation (new Implementation ()) {
-  }
+  ThreadCachedRepresentation thread_cached_representation_object;
 
-  ~Representation (void) noexcept {
-    
-    delete this->implementation;
-    
-    this->implementation = nullptr;
-  }
+  thread_cached_representation_object.ExecuteBehaviour ();
 
-  void ExecuteBehaviour (void) const {
-  
-    this->implementation->Behaviour ();  
-  }
+  // ...or stored right inside the representation, with no allocation at all:
 
-private:
+  InlineRepresentation inline_representation_object;
 
-  Implementation* implementation;
+  inline_representation_object.ExecuteBehaviour ();
 
-};
+  // Any type can be the implementation, allocated through a policy or stored inline:
 
+  Pimpl<std::string, 0, alignof (std::max_align_t), ThreadCachedSlabAllocation> pooled_implementation (std::in_place, "A pooled std::string");
 
-int main (int arg_count, char* arg_vector []) {
-  
-  // Demonstration of the Handle Body Idiom:
+  Pimpl<std::string, sizeof (std::string)> inline_implementation (std::in_place, "An inline std::string");
 
-  Representation representation_object;
-  
-  representation_object.ExecuteBehaviour ();
+  Output () << *pooled_implementation << " || " << *inline_implementation << '\n';
 
   return 0;
 }
@@ -0,0 +1,173 @@
+#ifndef HANDLE_BODY_HPP
+#define HANDLE_BODY_HPP
+
+#include <cstddef>
+#include <new>
+#include <string>
+
+#include "../Common/Allocation.hpp"
+#include "../Common/OutputSink.hpp"
+
+// The Handle Body Idiom.
+
+// Motivation:
+
+// (1) Although access specifiers certainly helps towards the principle of encapsulation, the implementation and the representation
+//     of the object is still hard-coupled to each other. This means that a change on the implementation of the object, will require
+//     a recompilation of the representation code (since they're written in the same spot).
+
+// (2) We take a hit on the object extensibility if we keep the implementation of the code in the same place as its representation
+//     since each representation methods are hard-coupled with the well-hidden but highly specialized implementation code.
+//     What this entails for us is that it will be unnecessarily difficult for us to change around our object implementation if
+//     something better comes up in the near future.
+
+// Solution:
+
+// (*) Create two objects: one for implementation and one for representation.
+
+// (*) The representation will be fully transparent with each necessary method being accessible to the public.
+
+// (*) As for the implementation, all methods will be private.
+//     This requires the implementation object to declare the representation object as a 'friend.'
+
+// (*) Any attempt to access a representation method is internally just a delegation to an implementation method.
+
+// (*) Every representation owns a heap-allocated implementation, so creating and destroying representations at a high rate is mostly
+//     a workout for the global allocator. Since all implementations of a type have the same size, they can instead come out of a pool:
+//     memory is carved out of large slabs and recycled through a free list rather than handed back. The implementation picks where it is
+//     allocated through an allocation policy (its class-specific operator new/delete), so the representation doesn't change at all.
+//     A thread-local cache in front of the pool lets each thread recycle its own blocks without taking the pool's lock. The pools and
+//     the policies live in Allocation.hpp.
+
+// (*) If the implementation is small, it doesn't need to live anywhere but inside the representation ("Fast Pimpl"). The representation
+//     reserves a suitably sized and aligned buffer and constructs the implementation into it, which removes the allocation as well as
+//     the pointer chase on every call. The price is that the representation's header has to commit to a size and an alignment, so
+//     the buffer is checked against the implementation at compile time and outgrowing it fails the build instead of corrupting memory.
+
+// (*) Everything above is written against one implementation class. Pimpl.hpp applies the idiom to any type, with the inline size and
+//     the allocation policy as template parameters.
+
+// Structure:
+
+
+template <typename AllocationPolicy>
+class BasicImplementation {
+
+  template <typename> friend class BasicRepresentation;
+
+  template <std::size_t, std::size_t> friend class BasicInlineRepresentation;
+
+private:
+
+  BasicImplementation (void) {
+  }
+
+  ~BasicImplementation (void) noexcept {
+  }
+
+  static void* operator new (std::size_t) {
+
+    return AllocationPolicy::template Allocate<BasicImplementation> ();
+  }
+
+  static void operator delete (void* memory) noexcept {
+
+    AllocationPolicy::template Release<BasicImplementation> (memory);
+  }
+
+  void Behaviour (void) const {
+
+    Output () << "Behaviour called from the Implementation class through the Representation class.\n";
+  }
+
+};
+
+
+template <typename AllocationPolicy>
+class BasicRepresentation {
+
+public:
+
+  BasicRepresentation (void)
+
+      : implementation (new BasicImplementation<AllocationPolicy> ()) {
+  }
+
+  ~BasicRepresentation (void) noexcept {
+
+    delete this->implementation;
+
+    this->implementation = nullptr;
+  }
+
+  void ExecuteBehaviour (void) const {
+
+    this->implementation->Behaviour ();
+  }
+
+private:
+
+  BasicImplementation<AllocationPolicy>* implementation;
+
+};
+
+
+template <std::size_t StorageSize, std::size_t StorageAlignment>
+class BasicInlineRepresentation {
+
+public:
+
+  BasicInlineRepresentation (void) {
+
+    ::new (static_cast<void*> (this->storage)) Implementation ();
+  }
+
+  BasicInlineRepresentation (const BasicInlineRepresentation&) = delete;
+
+  BasicInlineRepresentation& operator= (const BasicInlineRepresentation&) = delete;
+
+  ~BasicInlineRepresentation (void) noexcept {
+
+    static_assert (sizeof (Implementation) <= StorageSize, "The implementation doesn't fit into the representation's storage.");
+
+    static_assert (StorageAlignment % alignof (Implementation) == 0, "The representation's storage is not aligned for the implementation.");
+
+    this->GetImplementation ()->~Implementation ();
+  }
+
+  void ExecuteBehaviour (void) const {
+
+    this->GetImplementation ()->Behaviour ();
+  }
+
+private:
+
+  using Implementation = BasicImplementation<InlineAllocation>;
+
+  Implementation* GetImplementation (void) {
+
+    return std::launder (reinterpret_cast<Implementation*> (this->storage));
+  }
+
+  const Implementation* GetImplementation (void) const {
+
+    return std::launder (reinterpret_cast<const Implementation*> (this->storage));
+  }
+
+  alignas (StorageAlignment) unsigned char storage [StorageSize];
+};
+
+
+// Implementations allocated from the global heap.
+using Representation = BasicRepresentation<HeapAllocation>;
+
+// Implementations allocated from a slab pool shared by all threads.
+using PooledRepresentation = BasicRepresentation<SlabAllocation>;
+
+// Implementations allocated from a per-thread cache in front of the slab pool.
+using ThreadCachedRepresentation = BasicRepresentation<ThreadCachedSlabAllocation>;
+
+// Implementations stored inside the representation, in the space the implementation pointer would have taken.
+using InlineRepresentation = BasicInlineRepresentation<sizeof (void*), alignof (void*)>;
+
+#endif
@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "HandleBody.hpp"
+#include "../Common/LifecycleBenchmarks.hpp"
+
+// Handle Body Idiom Benchmarks.
+
+// Build: g++ -std=c++17 -O2 HandleBodyBenchmark.cpp -lbenchmark -lpthread
+
+// Churn: representations are created and destroyed in a tight loop with every allocation policy.
+
+// (*) Tight churn creates and destroys one representation per iteration, so the same block is recycled over and over.
+
+// (*) Batch churn creates a batch of representations before destroying all of them, so the free lists actually have to grow and shrink.
+
+// (*) Both run from 1 to 8 threads; the shared slab pool serializes on its lock, the thread cache only touches it once per half cache.
+
+// Cold calls: ExecuteBehaviour is called on representations in random order out of a set far larger than the core's private caches,
+// heap-allocated against inline implementations. Output goes to a NullOutputSink while they run, so the call path is measured rather
+// than the terminal.
+
+// Lifecycle: construction, destruction and dispatch for every representation, on warm and cold batches from 1 to 8 threads (see
+// LifecycleBenchmarks.hpp). A representation owns its implementation outright and can't be copied, so there is nothing else to measure.
+
+
+template <typename Handle>
+static void TightChurn (benchmark::State& state) {
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      Handle representation_object;
+
+      benchmark::DoNotOptimize (representation_object);
+    }
+  }
+
+  ReportAllocations (state, state.iterations ());
+}
+
+BENCHMARK_TEMPLATE (TightChurn, Representation)->ThreadRange (1, 8)->UseRealTime ();
+
+BENCHMARK_TEMPLATE (TightChurn, PooledRepresentation)->ThreadRange (1, 8)->UseRealTime ();
+
+BENCHMARK_TEMPLATE (TightChurn, ThreadCachedRepresentation)->ThreadRange (1, 8)->UseRealTime ();
+
+BENCHMARK_TEMPLATE (TightChurn, InlineRepresentation)->ThreadRange (1, 8)->UseRealTime ();
+
+
+template <typename Handle>
+static void BatchChurn (benchmark::State& state) {
+
+  std::vector<std::optional<Handle>> representation_objects (state.range (0));
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      for (auto& representation_object : representation_objects) {
+
+        representation_object.emplace ();
+      }
+
+      for (auto& representation_object : representation_objects) {
+
+        representation_object.reset ();
+      }
+    }
+  }
+
+  state.SetItemsProcessed (state.iterations () * state.range (0));
+
+  ReportAllocations (state, state.iterations () * state.range (0));
+}
+
+BENCHMARK_TEMPLATE (BatchChurn, Representation)->Arg (1 << 12)->ThreadRange (1, 8)->UseRealTime ();
+
+BENCHMARK_TEMPLATE (BatchChurn, PooledRepresentation)->Arg (1 << 12)->ThreadRange (1, 8)->UseRealTime ();
+
+BENCHMARK_TEMPLATE (BatchChurn, ThreadCachedRepresentation)->Arg (1 << 12)->ThreadRange (1, 8)->UseRealTime ();
+
+
+template <typename Handle>
+static void ColdCall (benchmark::State& state) {
+
+  std::vector<Handle> representation_objects (state.range (0));
+
+  std::vector<std::size_t> visiting_order (representation_objects.size ());
+
+  std::iota (visiting_order.begin (), visiting_order.end (), 0);
+
+  std::shuffle (visiting_order.begin (), visiting_order.end (), std::mt19937_64 (42));
+
+  NullOutputSink null_output_sink;
+
+  OutputSink& previous_output_sink = SetOutputSink (null_output_sink);
+
+  std::size_t next = 0;
+
+  {
+    CountedAllocations counted_allocations (state);
+
+    for (auto _ : state) {
+
+      representation_objects [visiting_order [next]].ExecuteBehaviour ();
+
+      next = (next + 1 == visiting_order.size ()) ? 0 : next + 1;
+    }
+  }
+
+  SetOutputSink (previous_output_sink);
+
+  ReportAllocations (state, state.iterations ());
+}
+
+BENCHMARK_TEMPLATE (ColdCall, Representation)->Arg (1 << 22);
+
+BENCHMARK_TEMPLATE (ColdCall, InlineRepresentation)->Arg (1 << 22);
+
+
+// Lifecycle suite (LifecycleBenchmarks.hpp).
+
+BENCHMARK_TEMPLATE (Construction, Representation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Construction, PooledRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Construction, ThreadCachedRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Construction, InlineRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Destruction, Representation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Destruction, PooledRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Destruction, ThreadCachedRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Destruction, InlineRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Dispatch, Representation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Dispatch, PooledRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Dispatch, ThreadCachedRepresentation)->Apply (LifecycleRuns);
+
+BENCHMARK_TEMPLATE (Dispatch, InlineRepresentation)->Apply (LifecycleRuns);
+
+
+BENCHMARK_MAIN ();
@@ -0,0 +1,105 @@
+#include <cassert>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "HandleBody.hpp"
+#include "Pimpl.hpp"
+
+
+// Copying, moving and assigning have to give each Pimpl an implementation of its own, whichever way it is stored.
+template <typename StringPimpl>
+void CheckValueSemantics (void) {
+
+  StringPimpl first_pimpl (std::in_place, "first");
+
+  StringPimpl copied_pimpl (first_pimpl);
+
+  assert (*copied_pimpl == "first" && &*copied_pimpl != &*first_pimpl);
+
+  copied_pimpl->append (" changed");
+
+  assert (*first_pimpl == "first");
+
+  StringPimpl assigned_pimpl (std::in_place, "second");
+
+  assigned_pimpl = first_pimpl;
+
+  assert (*assigned_pimpl == "first" && &*assigned_pimpl != &*first_pimpl);
+
+  StringPimpl& same_pimpl = assigned_pimpl;
+
+  assigned_pimpl = same_pimpl;
+
+  assert (*assigned_pimpl == "first");
+
+  StringPimpl moved_pimpl (std::move (copied_pimpl));
+
+  assert (*moved_pimpl == "first changed");
+
+  moved_pimpl = StringPimpl (std::in_place, "third");
+
+  assert (*moved_pimpl == "third");
+}
+
+// A thread-local that outlives the thread's cache, since it was constructed before it, releases its representations from its destructor:
+// they go back to the pool itself, and so does a representation created from there.
+void CheckReleaseAfterThreadCache (void) {
+
+  std::thread ([] (void) {
+
+    struct LateRelease {
+
+      ~LateRelease (void) noexcept {
+
+        this->representations.clear ();
+
+        ThreadCachedRepresentation late_representation;
+      }
+
+      std::vector<ThreadCachedRepresentation> representations;
+    };
+
+    thread_local LateRelease late_release;
+
+    late_release.representations.resize (100);
+  }).join ();
+}
+
+
+int main (void) {
+
+  // Representations are created and destroyed in bulk, so the pools hand freed implementations out again.
+
+  for (int round = 0; round < 2; ++round) {
+
+    std::vector<Representation> representations (100);
+
+    std::vector<PooledRepresentation> pooled_representations (100);
+
+    std::vector<ThreadCachedRepresentation> thread_cached_representations (100);
+
+    InlineRepresentation inline_representation;
+
+    representations.front ().ExecuteBehaviour ();
+
+    pooled_representations.back ().ExecuteBehaviour ();
+
+    thread_cached_representations.back ().ExecuteBehaviour ();
+
+    inline_representation.ExecuteBehaviour ();
+  }
+
+  CheckReleaseAfterThreadCache ();
+
+  CheckValueSemantics<Pimpl<std::string>> ();
+
+  CheckValueSemantics<Pimpl<std::string, 0, alignof (std::max_align_t), SlabAllocation>> ();
+
+  CheckValueSemantics<Pimpl<std::string, 0, alignof (std::max_align_t), ThreadCachedSlabAllocation>> ();
+
+  CheckValueSemantics<Pimpl<std::string, sizeof (std::string)>> ();
+
+  return 0;
+}
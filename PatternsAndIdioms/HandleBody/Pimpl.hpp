@@ -0,0 +1,219 @@
+#ifndef PIMPL_HPP
+#define PIMPL_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "../Common/Allocation.hpp"
+
+// Pimpl.
+
+// The Handle Body Idiom for any implementation type, rather than for the one BasicImplementation of HandleBody.hpp: a class keeps a
+// Pimpl<Implementation> member, and the representation never has to know what the implementation looks like.
+
+// (*) With an InlineSize of zero the implementation is allocated through an allocation policy (HeapAllocation, SlabAllocation or
+//     ThreadCachedSlabAllocation, from Allocation.hpp). With an InlineSize above zero it is constructed right inside the Pimpl instead
+//     (the "Fast Pimpl"), and a size or alignment that doesn't fit fails the build. Either way the choice is a template parameter, so
+//     the calls through the Pimpl are direct and specialized for it.
+
+// (*) The implementation only has to be complete where a Pimpl is created, copied or destroyed. A class that wants to keep it out of its
+//     header declares its constructors, destructor and assignments there and defines them next to the implementation.
+
+// (*) A Pimpl owns its implementation: copying a Pimpl copies the implementation, and constness carries over from the Pimpl to it. A Pimpl
+//     whose allocated implementation was moved away can only be assigned to or destroyed.
+
+
+template <typename Implementation, std::size_t InlineSize = 0, std::size_t InlineAlignment = alignof (std::max_align_t),
+          typename AllocationPolicy = HeapAllocation>
+class Pimpl {
+
+public:
+
+  // A default constructed implementation.
+  Pimpl (void)
+
+      : Pimpl (std::in_place) {
+  }
+
+  // An implementation constructed from the arguments.
+  template <typename... Arguments>
+  explicit Pimpl (std::in_place_t, Arguments&&... arguments) {
+
+    this->Construct (std::forward<Arguments> (arguments)...);
+  }
+
+  Pimpl (const Pimpl& another_pimpl) {
+
+    this->Construct (*another_pimpl);
+  }
+
+  // Moving an allocated implementation steals it and leaves the source empty; an inline one is moved into the new storage.
+  Pimpl (Pimpl&& another_pimpl) noexcept (is_inline ? std::is_nothrow_move_constructible_v<Implementation> : true) {
+
+    if constexpr (is_inline) {
+
+      this->Construct (std::move (*another_pimpl));
+    }
+    else {
+
+      this->storage.implementation = another_pimpl.storage.implementation;
+
+      another_pimpl.storage.implementation = nullptr;
+    }
+  }
+
+  ~Pimpl (void) noexcept {
+
+    this->Destroy ();
+  }
+
+  Pimpl& operator= (const Pimpl& another_pimpl) {
+
+    if (this == &another_pimpl) {
+
+      return *this;
+    }
+
+    if (this->GetImplementation () == nullptr) {
+
+      this->Construct (*another_pimpl);
+    }
+    else {
+
+      **this = *another_pimpl;
+    }
+
+    return *this;
+  }
+
+  Pimpl& operator= (Pimpl&& another_pimpl) noexcept (is_inline ? std::is_nothrow_move_assignable_v<Implementation> : true) {
+
+    if (this == &another_pimpl) {
+
+      return *this;
+    }
+
+    if constexpr (is_inline) {
+
+      **this = std::move (*another_pimpl);
+    }
+    else {
+
+      this->Destroy ();
+
+      this->storage.implementation = another_pimpl.storage.implementation;
+
+      another_pimpl.storage.implementation = nullptr;
+    }
+
+    return *this;
+  }
+
+  Implementation& operator* (void) noexcept {
+
+    return *this->GetImplementation ();
+  }
+
+  const Implementation& operator* (void) const noexcept {
+
+    return *this->GetImplementation ();
+  }
+
+  Implementation* operator-> (void) noexcept {
+
+    return this->GetImplementation ();
+  }
+
+  const Implementation* operator-> (void) const noexcept {
+
+    return this->GetImplementation ();
+  }
+
+private:
+
+  static constexpr bool is_inline = InlineSize > 0;
+
+  struct AllocatedStorage {
+
+    Implementation* implementation;
+  };
+
+  struct InlineStorage {
+
+    alignas (InlineAlignment) unsigned char bytes [is_inline ? InlineSize : 1];
+  };
+
+  std::conditional_t<is_inline, InlineStorage, AllocatedStorage> storage;
+
+  template <typename... Arguments>
+  void Construct (Arguments&&... arguments) {
+
+    if constexpr (is_inline) {
+
+      static_assert (sizeof (Implementation) <= InlineSize, "The implementation doesn't fit into the Pimpl's storage.");
+
+      static_assert (InlineAlignment % alignof (Implementation) == 0, "The Pimpl's storage is not aligned for the implementation.");
+
+      ::new (static_cast<void*> (this->storage.bytes)) Implementation (std::forward<Arguments> (arguments)...);
+    }
+    else {
+
+      void* memory = AllocationPolicy::template Allocate<Implementation> ();
+
+      try {
+
+        this->storage.implementation = ::new (memory) Implementation (std::forward<Arguments> (arguments)...);
+      }
+      catch (...) {
+
+        AllocationPolicy::template Release<Implementation> (memory);
+
+        throw;
+      }
+    }
+  }
+
+  void Destroy (void) noexcept {
+
+    if constexpr (is_inline) {
+
+      this->GetImplementation ()->~Implementation ();
+    }
+    else if (this->storage.implementation != nullptr) {
+
+      this->storage.implementation->~Implementation ();
+
+      AllocationPolicy::template Release<Implementation> (this->storage.implementation);
+
+      this->storage.implementation = nullptr;
+    }
+  }
+
+  Implementation* GetImplementation (void) noexcept {
+
+    if constexpr (is_inline) {
+
+      return std::launder (reinterpret_cast<Implementation*> (this->storage.bytes));
+    }
+    else {
+
+      return this->storage.implementation;
+    }
+  }
+
+  const Implementation* GetImplementation (void) const noexcept {
+
+    if constexpr (is_inline) {
+
+      return std::launder (reinterpret_cast<const Implementation*> (this->storage.bytes));
+    }
+    else {
+
+      return this->storage.implementation;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,36 @@
+#!/bin/sh
+
+# Builds the benchmarks of every idiom with a CMake preset (release unless CLEANCODE_PRESET says otherwise, e.g. lto or pgo-use) and
+# runs them, keeping the results as JSON, one file per idiom.
+
+# Usage: ./RunBenchmarks.sh [results directory] [benchmark arguments...]
+
+# Any arguments after the results directory go to every benchmark (--benchmark_filter=Copying, --benchmark_repetitions=5, ...).
+# To catch regressions, keep the results of two versions and compare them idiom by idiom with tools/compare.py from Google Benchmark:
+
+#   compare.py benchmarks old/CountedBody.json new/CountedBody.json
+
+set -e
+
+project_directory="$(cd "$(dirname "$0")/.." && pwd)"
+
+preset="${CLEANCODE_PRESET:-release}"
+
+results_directory="${1:-$project_directory/build/BenchmarkResults}"
+
+[ $# -gt 0 ] && shift
+
+mkdir -p "$results_directory"
+
+results_directory="$(cd "$results_directory" && pwd)"
+
+cd "$project_directory"
+
+cmake --preset "$preset"
+
+cmake --build --preset "$preset"
+
+for idiom in Bridge Clone CountedBody DetachedCountedBody HandleBody; do
+
+  "build/$preset/PatternsAndIdioms/$idiom/${idiom}Benchmark" --benchmark_out="$results_directory/$idiom.json" --benchmark_out_format=json "$@"
+done